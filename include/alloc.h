@@ -0,0 +1,78 @@
+#ifndef __ALLOC_H_
+#define __ALLOC_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace mcts {
+
+/**
+ * Accounting of the heap allocations. The binaries linked with alloc_hook.cpp
+ * (testAlloc, and all of them in the Debug builds or with COUNT_ALLOCS on) have
+ * the global operator new replaced to count the allocations and their bytes, by
+ * thread and by phase of the search: the agent tags its phases with a Scope,
+ * everything else being PHASE_OTHER. The counters are the calling thread's, there
+ * is no synchronization. Without the hook they stay at zero, see counting().
+ *
+ * A search in its steady state shouldn't allocate at all, the nodes excepted
+ * when they go in the keyed table: see testAlloc.cpp. The exceptions are the
+ * searches with an Evaluator: the agent's first batched search starts its
+ * AsyncEvaluator thread, kept for the agent's lifetime, and each batch allocates
+ * its leaves, its evaluations and the future they come back through.
+ */
+namespace Alloc {
+
+    enum Phase {
+        PHASE_OTHER,
+        PHASE_SELECTION,        // tree_policy(), with the nodes created in the table.
+        PHASE_EXPANSION,        // init_children().
+        PHASE_SIMULATION,       // The rollouts and the exact values of the moves.
+        PHASE_BACKPROPAGATION,
+        PHASE_NB
+    };
+
+    struct Counters {
+        uint64_t allocs = 0;
+        uint64_t bytes  = 0;
+    };
+
+    struct Stats {
+        std::array<Counters, PHASE_NB> phases {};
+
+        Counters total() const;
+        Stats operator-(const Stats& before) const;
+    };
+
+    // The counters of the calling thread since it started.
+    Stats stats();
+
+    // Whether the allocations are counted at all, i.e. the hook is linked in.
+    bool counting();
+
+    // For alloc_hook.cpp.
+    void record(size_t size);
+    bool install();
+
+    const char* phase_name(Phase);
+    std::ostream& operator<<(std::ostream&, const Stats&);
+
+    // The allocations of the calling thread go to `phase` until the scope ends.
+    class Scope {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Phase m_previous;
+    };
+
+}  // namespace Alloc
+
+}  // namespace mcts
+
+#endif // __ALLOC_H_
@@ -0,0 +1,76 @@
+#ifndef __ANYTIME_H_
+#define __ANYTIME_H_
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "mcts.h"
+
+namespace mcts {
+
+/**
+ * Runs an agent's search on a thread of its own, for callers whose deadline
+ * isn't known when the search starts. The search goes on until stop() or the
+ * agent's budget, so set MAX_ITER (and use_time) generously for anytime use.
+ *
+ *     SearchHandle<> handle(agent);
+ *     handle.subscribe([](const SearchInfo& si) { ... }, 50);
+ *     handle.start();
+ *     ...
+ *     Move move = handle.stop();
+ *
+ * stop() doesn't wait for the search thread: it returns the best move published
+ * by the last iteration. The tree and the state belong to the search thread until
+ * wait() returns, the callbacks are called from it too.
+ */
+template<class A = Agent>
+class SearchHandle {
+public:
+    explicit SearchHandle(A& agent) : agent(agent) { }
+    ~SearchHandle() { stop(); wait(); }
+    SearchHandle(const SearchHandle&) = delete;
+    SearchHandle& operator=(const SearchHandle&) = delete;
+
+    // Must be called while no search is running.
+    void subscribe(std::function<void(const SearchInfo&)> callback, int period_ms = 100) {
+        agent.set_update(std::move(callback), period_ms);
+    }
+
+    // `on_done` is called from the search thread with the chosen move, however the search ends.
+    void start(std::function<void(Move)> on_done = {}) {
+        wait();
+        agent.clear_stop();
+        agent.reset_best_move();
+        done = false;
+        worker = std::thread([this, on_done = std::move(on_done)]() {
+            result = agent.MCTSBestMove();
+            done.store(true, std::memory_order_release);
+            if (on_done)
+                on_done(result);
+        });
+    }
+
+    Move stop() {
+        agent.stop();
+        return agent.best_so_far();
+    }
+
+    // Blocks until the search is over and returns the move it chose.
+    Move wait() {
+        if (worker.joinable())
+            worker.join();
+        return result;
+    }
+
+    bool running() const { return worker.joinable() && !done.load(std::memory_order_acquire); }
+
+private:
+    A&                agent;
+    std::thread       worker;
+    std::atomic<bool> done { true };
+    Move              result = MOVE_NONE;
+};
+
+} // namespace mcts
+
+#endif // __ANYTIME_H_
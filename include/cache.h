@@ -0,0 +1,105 @@
+#ifndef __CACHE_H_
+#define __CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "mcts.h"
+
+namespace mcts {
+
+/**
+ * The decisions of the searches, by position, budget and configuration, so that a position seen
+ * before (or one of its images by the symmetries of the board) is answered
+ * without searching: the agents check it at the start of MCTSBestMove and fill it
+ * at the end of the searches which ran to their budget (see Agent::decision_cache).
+ *
+ * The positions are in canonical form, the least base-3 index of their 8 images,
+ * and the moves of a decision are kept in the orientation of that image. The cache
+ * is split in shards, each one a least recently used list under its own mutex, so
+ * that concurrent requests seldom wait on each other.
+ */
+class DecisionCache {
+public:
+    static constexpr int SYMMETRIES = 8;
+
+    struct Decision {
+        Move    move        = MOVE_NONE;
+        int     iterations  = 0;
+        int     root_visits = 0;
+        Reward  value       = 0;                // Mean value of the move, for the player making it.
+        int     n_children  = 0;
+        std::array<std::pair<Move, int>, State::MAX_MOVES> visits {};    // Visits of each move of the root.
+    };
+
+    explicit DecisionCache(size_t capacity = 1 << 16, int n_shards = 16);
+
+    // The decision for the position, the budget and the configuration, in the position's orientation.
+    std::optional<Decision> find(const State& state, int budget, uint64_t config = 0);
+    void insert(const State& state, int budget, const Decision& decision, uint64_t config = 0);
+    void clear();
+
+    size_t size() const;
+    size_t capacity() const { return per_shard * shards.size(); }
+    uint64_t hits() const { return n_hits.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return n_misses.load(std::memory_order_relaxed); }
+
+    // The budget of the agents' searches: the iterations, or minus the time.
+    static int budget() { return AgentBase::use_time ? -AgentBase::MAX_TIME : AgentBase::MAX_ITER; }
+
+    // The configuration of the agents' searches: the knobs of the profile changing
+    // their decisions, and the agent's policies.
+    template<class Selection, class Final>
+    static uint64_t config() { return AgentBase::profile_hash() ^ policies_hash(typeid(Selection), typeid(Final)); }
+    static uint64_t policies_hash(const std::type_info& selection, const std::type_info& final);
+
+    // The least index of the images of the position, and the symmetry giving it.
+    static std::pair<int, int> canonical(const State& state);
+
+    // The move by the symmetry, and back.
+    static Move transform(Move move, int symmetry);
+    static Move inverse(Move move, int symmetry);
+
+private:
+    // The whole key is compared, two entries whose hashes collide don't share their decision.
+    struct EntryKey {
+        int      index;
+        int      budget;
+        uint64_t config;
+
+        bool operator==(const EntryKey&) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const EntryKey& k) const;
+    };
+
+    struct Entry {
+        EntryKey key;
+        Decision decision;
+    };
+
+    struct Shard {
+        mutable std::mutex                                              mtx;
+        std::list<Entry>                                                lru;    // Most recently used first.
+        std::unordered_map<EntryKey, std::list<Entry>::iterator, KeyHash> map;
+    };
+
+    Shard& shard(const EntryKey& key);
+
+    std::vector<Shard>      shards;
+    size_t                  per_shard;
+    std::atomic<uint64_t>   n_hits { 0 };
+    std::atomic<uint64_t>   n_misses { 0 };
+};
+
+}  // namespace mcts
+
+#endif // __CACHE_H_
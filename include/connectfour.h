@@ -0,0 +1,116 @@
+#ifndef __CONNECTFOUR_H_
+#define __CONNECTFOUR_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "tictactoe.h"
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * Connect Four on the 7x6 board, the deep game of the benchmarks (42 plies, millions
+ * of positions) next to tic-tac-toe. It is made and unmade like State, with the same
+ * StateData records and the same status bits in the keys, so key_terminal() and
+ * key_ev_terminal() apply to it too.
+ *
+ * The board is a pair of bitboards in the classic layout, column by column with a
+ * sentinel row on top of each column:
+ *
+ *    6 13 20 27 34 41 48
+ *    5 12 19 26 33 40 47
+ *    ...
+ *    0  7 14 21 28 35 42
+ *
+ * so that four in a row, in any direction, is found with three shifts and ands.
+ * Moves are the columns: Move(1) through Move(7), the side being the player to move.
+ */
+class ConnectFour {
+    public:
+    using bitboard_t = uint64_t;
+    using key_type = Key;
+    using Data = StateData;
+
+    static constexpr int WIDTH = 7;
+    static constexpr int HEIGHT = 6;
+    static constexpr int H1 = HEIGHT + 1;       // Bits per column, with the sentinel.
+    static constexpr int MAX_MOVES = WIDTH;
+    static constexpr int MAX_GAME_PLY = WIDTH * HEIGHT;
+
+    ConnectFour();
+    // A copy starts from the position of the original, its moves can't be undone.
+    ConnectFour(const ConnectFour&);
+    ConnectFour& operator=(const ConnectFour&);
+
+    // Game logic
+    Token winner() const;
+    Token next_player() const;
+    bool is_full() const;
+    bool is_terminal() const;
+    bool is_draw() const;
+    bool is_valid(Move move) const;
+    std::vector<Move>& valid_actions();
+    void apply_move(Move, StateData&);
+    void undo_move(Move);
+
+    static bool terminal(const StateData&);
+    static Reward terminal_value(const StateData&);
+
+    // Zobrist keys
+    Key key() const;
+    Key key_after(Move) const;                  // Key of the state after the move, without making it.
+
+    StateData* data;
+    int gamePly = 1;
+
+    bitboard_t board(Token) const;              // Stones of a player.
+    Token at(int col, int row) const;
+
+    static int moveToColumn(Move m);
+    static Move columnToMove(int col);
+
+    // Four in a row among the stones.
+    static bool is_win(bitboard_t stones);
+
+private:
+    std::array<bitboard_t, 2> m_board {};       // Indexed by Token - 1.
+    std::array<int, WIDTH> m_height {};         // Index of the next free bit of each column.
+    std::vector<Move> m_valid_actions;
+    StateData m_start;                          // The data of the starting position.
+};
+
+namespace Zobrist {
+
+    // The key of a stone of the player `token` on the bit `square` of the board.
+    inline constexpr auto square_keys = make_square_keys<2 * ConnectFour::WIDTH * ConnectFour::H1>(2080331);
+
+    constexpr Key stoneKey(int square, Token token) {
+        return square_keys[(token - 1) * ConnectFour::WIDTH * ConnectFour::H1 + square];
+    }
+
+}  // namespace Zobrist
+
+inline bool ConnectFour::terminal(const StateData& sd) {
+    return key_terminal(sd.key);
+}
+
+inline Reward ConnectFour::terminal_value(const StateData& sd) {
+    return key_ev_terminal(sd);
+}
+
+inline bool ConnectFour::is_win(bitboard_t b) {
+    // Vertical, horizontal and the two diagonals.
+    for (int d : { 1, H1, H1 - 1, H1 + 1 })
+    {
+        bitboard_t pairs = b & (b >> d);
+        if (pairs & (pairs >> 2 * d))
+            return true;
+    }
+    return false;
+}
+
+} // namespace mcts
+
+
+#endif // __CONNECTFOUR_H_
@@ -0,0 +1,26 @@
+#ifndef __DEBUG_H_
+#define __DEBUG_H_
+
+#include <iostream>
+#include "tictactoe.h"
+
+namespace mcts {
+namespace Debug {
+
+// The board, row by row, with '.' for the empty cells.
+inline void display(std::ostream& os, const State& state)
+{
+    const auto& grid = state.grid();
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+            os << (grid[3 * r + c] == X ? 'X' : grid[3 * r + c] == O ? 'O' : '.');
+        os << '\n';
+    }
+    os << "Ply " << state.gamePly << ", key " << state.key() << '\n';
+}
+
+}  // namespace Debug
+}  // namespace mcts
+
+#endif // __DEBUG_H_
@@ -0,0 +1,106 @@
+#ifndef __ENGINE_H_
+#define __ENGINE_H_
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "anytime.h"
+#include "cache.h"
+#include "mcts.h"
+#include "shared.h"
+
+namespace mcts {
+
+/**
+ * A long running engine speaking a line based protocol, in the spirit of UCI:
+ * commands are read by loop() and answers written to `out` (stdin and stdout
+ * for the main binary). Moves are the cells, numbered 1 to 9 row by row.
+ *
+ *   position startpos [moves c1 c2 ...]   Set up the position.
+ *   go [movetime MS] [iterations N] [infinite]
+ *                                         Search, ends with `bestmove c`.
+ *   ponder                                Search the position after the reply expected
+ *                                         to the engine's last move (the current one if
+ *                                         there is none) until stop, or until the
+ *                                         position changes.
+ *   stop                                  Answers `bestmove c` at once, or ends the
+ *                                         ponder search without answering.
+ *   setoption name NAME value VALUE       Any knob of the profiles, `profile FILE`, or
+ *                                         `shared /NAME` to search along with the other
+ *                                         engines using the same shared memory segment,
+ *                                         or `cache N` to answer the positions searched
+ *                                         before from a cache of N decisions (0 for none).
+ *   stats                                 Size of the table and last search's counters.
+ *   isready                               Answers `readyok`.
+ *   quit
+ *
+ * The commands needing the agent wait for the current search to end, except
+ * for the ponder and infinite searches which are stopped (without a bestmove).
+ * While searching, `info` lines are sent every `info_period` milliseconds. The table
+ * is kept between the commands, so the search goes on from the previous trees.
+ */
+class Engine {
+public:
+    explicit Engine(std::ostream& out = std::cout) : out(out), agent(state), handle(agent) {
+        Agent::debug_counters = false;
+        handle.subscribe([this](const SearchInfo& si) { send_info(si); }, info_period);
+    }
+
+    // Waits for the search, and unplugs the shared table and the cache from the agents.
+    ~Engine();
+
+    void loop(std::istream& in);
+
+private:
+    void position(std::istringstream& is);
+    void go(std::istringstream& is);
+    void ponder();
+    void stop();
+    void setoption(std::istringstream& is);
+    void stats();
+    void finish();
+    void save_budget();
+    void expect_reply(Move move);
+    void unponder();
+
+    void send(const std::string& line);
+    void send_info(const SearchInfo& si);
+    void send_bestmove(Move move);
+
+    static int to_cell(Move move) { return State::moveToCell(move) + 1; }
+
+    std::ostream&              out;
+    State                      state;
+    std::array<StateData, 10>  sd;
+    Agent                      agent;
+    SharedTable                shared;
+    std::unique_ptr<DecisionCache> cache;
+    SearchHandle<>             handle;    // After what its search uses, so that it is destroyed first.
+
+    std::mutex                 out_mtx;
+    std::atomic<bool>          reported { true };    // The last search's bestmove was sent (or isn't due).
+    bool                       pondering = false;
+    bool                       infinite = false;     // The search only ends with a stop.
+    int                        info_period = 250;
+
+    // The reply the last go search expects to its move, and the position after that
+    // move. The ponder search plays it on `ponder_sd`, finish() takes it back.
+    Key                        ponder_key = 0;
+    Move                       ponder_reply = MOVE_NONE;
+    Move                       pondered = MOVE_NONE;
+    StateData                  ponder_sd;
+
+    // Budget of the regular searches, the go and ponder options only apply to one search.
+    bool budget_saved = false;
+    int  saved_iter = 0;
+    int  saved_time = 0;
+    bool saved_use_time = false;
+};
+
+} // namespace mcts
+
+#endif // __ENGINE_H_
@@ -0,0 +1,115 @@
+#ifndef __EVALUATOR_H_
+#define __EVALUATOR_H_
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mcts.h"
+
+namespace mcts {
+
+namespace Solver { class Table; }
+
+/**
+ * A leaf position waiting for its evaluation, with the moves the
+ * evaluator must give priors for.
+ */
+struct Leaf {
+    State::grid_t                         grid;
+    Token                                 to_move;
+    Key                                   key;
+    int                                   n_moves;
+    std::array<Move, Agent::MAX_CHILDREN> moves;
+};
+
+/**
+ * Value of a leaf from the point of view of the side to move, and the
+ * probability of each move (in the order of Leaf::moves), PUCT-style.
+ */
+struct Evaluation {
+    Reward                                value;
+    std::array<double, Agent::MAX_CHILDREN> priors;
+};
+
+/**
+ * Leaf evaluation is done one batch at a time, so that the cost of an
+ * expensive evaluator is amortized over all the leaves of a batch.
+ */
+class Evaluator {
+public:
+    virtual ~Evaluator() = default;
+    virtual void evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out) = 0;
+};
+
+// Counts the open lines of both sides, favoring immediate wins and blocks.
+class HeuristicEvaluator : public Evaluator {
+public:
+    void evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out) override;
+};
+
+// Exact values from the perfect play table, priors concentrated on the perfect moves.
+class TableEvaluator : public Evaluator {
+public:
+    explicit TableEvaluator(const Solver::Table& table) : table(table) { }
+    void evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out) override;
+
+private:
+    const Solver::Table& table;
+};
+
+/**
+ * Runs an Evaluator on a background thread, so that the search keeps
+ * selecting leaves while a batch is being evaluated. An agent keeps its
+ * own for all of its searches.
+ */
+class AsyncEvaluator {
+public:
+    explicit AsyncEvaluator(Evaluator& evaluator);
+    ~AsyncEvaluator();
+    AsyncEvaluator(const AsyncEvaluator&) = delete;
+    AsyncEvaluator& operator=(const AsyncEvaluator&) = delete;
+
+    std::future<std::vector<Evaluation>> submit(std::vector<Leaf> batch);
+
+    const Evaluator& target() const { return evaluator; }
+
+private:
+    struct Request {
+        std::vector<Leaf>                      leaves;
+        std::promise<std::vector<Evaluation>>  result;
+    };
+
+    void loop();
+
+    Evaluator&              evaluator;
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::deque<Request>     requests;
+    bool                    quit = false;
+    std::thread             worker;
+};
+
+/**
+ * The path of a leaf selected for evaluation: the edges were given a virtual
+ * visit (counted as a loss until the evaluation comes back) and the nodes are
+ * pending, so they are neither evicted nor selected again as leaves.
+ */
+struct PendingLeaf {
+    int                                          depth;
+    std::array<ActionNode*, Agent::MAX_PLY>      edges;
+    std::array<Node*, Agent::MAX_PLY>            nodes;    // nodes[depth] is the leaf.
+    std::array<Key, Agent::MAX_CHILDREN>         child_keys;    // After each move of the Leaf.
+};
+
+struct Batch {
+    std::vector<Leaf>                     leaves;
+    std::vector<PendingLeaf>              paths;
+    std::future<std::vector<Evaluation>>  result;
+};
+
+} // namespace mcts
+
+#endif // __EVALUATOR_H_
@@ -0,0 +1,78 @@
+#ifndef __GAME_H_
+#define __GAME_H_
+
+#include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <utility>
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * What the search needs from a game. The position is made and unmade in place,
+ * each move keeping its undo information in a `Data` record that the agent owns
+ * (one per ply, linked through `previous`), as State does with StateData.
+ *
+ * The capacities are the game's own: MAX_MOVES legal moves at most in a position
+ * and MAX_GAME_PLY plies at most in a game, which size the agent's buffers and
+ * its nodes at compile time. Terminal status and value are read from the Data
+ * record of the position, the value being from the point of view of the player
+ * who just moved (1 for a win, 0.5 for a draw).
+ */
+template<class G>
+concept Game = requires(G g, const G cg, Move m, typename G::Data& d, const typename G::Data& cd) {
+    requires std::unsigned_integral<typename G::key_type>;
+    { G::MAX_MOVES }            -> std::convertible_to<int>;
+    { G::MAX_GAME_PLY }         -> std::convertible_to<int>;
+
+    { d.key }                   -> std::convertible_to<typename G::key_type>;
+    { d.gamePly }               -> std::convertible_to<int>;
+    { g.data }                  -> std::convertible_to<typename G::Data*>;
+    { g.gamePly }               -> std::convertible_to<int>;
+
+    { cg.key() }                -> std::same_as<typename G::key_type>;
+    { cg.key_after(m) }         -> std::same_as<typename G::key_type>;
+    { g.valid_actions() }       -> std::ranges::random_access_range;
+    { g.apply_move(m, d) };
+    { g.undo_move(m) };
+
+    { G::terminal(cd) }         -> std::same_as<bool>;
+    { G::terminal_value(cd) }   -> std::convertible_to<Reward>;
+};
+
+/**
+ * The games with too many moves to expand them all may also give a cheap a priori
+ * value of the moves, prior(Move) in [0, 1], and bound the children of the nodes
+ * by MAX_CHILDREN: the nodes then keep the likeliest moves by prior.
+ */
+template<class G>
+concept HasPrior = Game<G> && requires(const G cg, Move m) {
+    { cg.prior(m) }             -> std::convertible_to<Reward>;
+};
+
+/**
+ * The games with a small state space may also number their positions: index() is
+ * exact (one position, one index) below INDEX_SIZE, and index_after(m) is the index
+ * after the move. The agents can then keep the nodes in a flat array, indexed
+ * directly, see AgentBase::direct_table.
+ */
+template<class G>
+concept Indexable = Game<G> && requires(const G cg, Move m) {
+    { G::INDEX_SIZE }           -> std::convertible_to<size_t>;
+    { cg.index() }              -> std::convertible_to<size_t>;
+    { cg.index_after(m) }       -> std::convertible_to<size_t>;
+};
+
+template<Game G>
+constexpr int max_children()
+{
+    if constexpr (requires { G::MAX_CHILDREN; })
+        return G::MAX_CHILDREN;
+    else
+        return G::MAX_MOVES;
+}
+
+} // namespace mcts
+
+#endif // __GAME_H_
@@ -1,138 +1,432 @@
 #ifndef __MCTS_H_
 #define __MCTS_H_
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <unordered_map>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "game.h"
 #include "tictactoe.h"
+#include "playout.h"
+#include "policy.h"
 #include "search.h"
 #include "type.h"
 
 namespace mcts {
 
-struct ActionNode;
-struct Node;
+class Snapshot;
+class SharedTable;
+class DecisionCache;
+class Evaluator;
+class AsyncEvaluator;
+struct Batch;
+namespace Solver { class Table; }
+namespace Trace { class Ring; }
 
+// The three least significant bits of a key are the status bits, so they are skipped.
 template<class Entry, int Size>
 struct HashTable {
-  Entry* operator[](Key key) { return &table[(uint32_t)key & (Size - 1)]; }
+  Entry* operator[](Key key) { return &table[(uint32_t)(key >> 3) & (Size - 1)]; }
 
 private:
   std::vector<Entry> table = std::vector<Entry>(Size);
 };
 
+// Entry of the alpha-beta transposition table used at the leaves.
+struct ABEntry {
+    enum Bound : int8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+    Key     key   = 0;
+    Reward  value = 0;
+    int8_t  depth = -1;
+    Bound   bound = BOUND_NONE;
+};
+
 // struct SearchStack {
 //     Move currentMove;
 //     int ply;
 //     Reward r;
 // };
 
-class Agent {
+// The knobs shared by all the agents, whatever their game and policies.
+class AgentBase {
 
 public:
-    static const int MAX_PLY = 12;
-    static const int MAX_CHILDREN = 10;
     static inline double exploration_cst = 0.7;
     static inline int MAX_TIME = 5000;    // In milliseconds.
+    static constexpr int TIME_MARGIN = 100;    // Of MAX_TIME, left for what comes after the search.
     static inline int MAX_ITER = 1000;
     static inline bool use_time            = false;
     static inline bool propagate_minimax;
+    static inline int n_rollouts           = 1;   // Random simulations per child on expansion.
+    static inline int leaf_playouts        = 0;   // Random playouts per leaf (0 to use the expansion's value).
+    static inline int playouts_decay       = 0;   // Leaf playouts dropped per ply below the root.
+    static inline const Snapshot* warm_start = nullptr;  // Tree saved by a previous process, if any.
+    static inline const Solver::Table* perfect_table = nullptr;  // Exact leaf values instead of rollouts.
+    static inline bool perfect_moves       = false;  // Play the perfect table's moves without searching.
+    static inline int ab_threshold         = 0;   // Solve leaves with at most this many empty cells by alpha-beta.
+    static inline bool graph_search        = false;  // Read child values from the (shared) child nodes.
+    static inline size_t max_bytes         = 0;   // Memory budget of the table (0 for no limit).
+    static inline uint32_t generation      = 0;   // Incremented at every search, to age the nodes.
+    static inline uint32_t table_epoch     = 1;   // Incremented when nodes are evicted, to invalidate child hints.
+    static inline Evaluator* evaluator     = nullptr;  // Batched leaf evaluation instead of rollouts.
+    static inline int batch_size           = 16;  // Leaves per batch sent to the evaluator.
+    static inline double puct_cst          = 1.5; // Exploration constant of the policies using priors.
+    static inline bool root_halving        = false;  // Sequential halving of MAX_ITER at the root, UCT below it.
+    static inline int halving_top_k        = 0;   // Root children entering the halving, by prior (0 for all).
+    static inline SharedTable* shared_table = nullptr;  // Edge statistics shared with other processes.
+    static inline double widening_cst      = 0;   // Progressive widening: a node considers widening_cst * n^widening_exp
+    static inline double widening_exp      = 0.5; // of its children after n visits (0 to consider them all at once).
+    static inline bool simd_playouts       = false;  // Tic-tac-toe playouts by batches, see playout.h.
+    static inline bool direct_table        = false;  // Nodes of the Indexable games in a flat array, see direct_nodes.
+    static inline bool trace_search        = false;  // Record the search events in the thread's ring, see trace.h.
+    static inline bool compact_tree        = false;  // Lay out the tree below the root in game_arena between the moves.
+    static inline size_t compact_max_nodes = 0;   // Nodes moved to the arena at most (0 for the whole tree).
+    static inline DecisionCache* decision_cache = nullptr;  // Moves of the previous searches, see cache.h.
+
+    // Wether to backpropagate the minmax value of nodes or the rollout reward.
+    static void set_backpropagate_minimax(bool);
+
+    // Sets a knob by name (as in the profiles), false if there is no such knob.
+    static bool set_option(const std::string& name, const std::string& value);
+
+    // Tuned parameter sets, one `name value` pair per line.
+    static bool load_profile(const std::string& path);
+    static bool save_profile(const std::string& path);
+    static uint64_t profile_hash();    // Of the knobs changing the decisions, see DecisionCache::config().
+
+    // Debugging
+    static void set_exp_c(double c);
+    static void set_max_time(int t);
+    static void set_search_time(int t);    // MAX_TIME for searches of `t` ms, the margin on top.
+    static void set_max_iter(int i);
+    static inline bool debug_counters      = true;
+    static inline bool debug_main_methods  = false;
+    static inline bool debug_tree          = false;
+    static inline bool debug_best_visits   = false;
+    static inline bool debug_init_children = false;
+    static inline bool debug_random_sim    = false;
+};
+
+template<Game G> struct BasicNode;
+
+template<Game G>
+struct BasicActionNode {
+    using key_type = typename G::key_type;
+
+    Move                move;
+    int                 n_visits;
+    Reward              prior_value;
+    Reward              action_value;
+    Reward              sq_action_value;         // Sum of the squared rewards, for the variance.
+    double              avg_action_value;
+    bool                decisive;                // If it is a known win etc...
+    int                 n_pending;               // Virtual visits among n_visits, see collect_batch().
+    double              policy;                  // Prior probability of the move for PUCT (uniform by default).
+    key_type            child_key;               // Key of the resulting position, 0 until known.
+    BasicNode<G>*       child;                   // The resulting node, valid only if child_epoch
+    uint32_t            child_epoch;             // is still the table's epoch (nodes can be evicted).
+};
+
+template<Game G>
+struct BasicNode {
+    // Careful when iterating through children, an ActionNode object doesn't have
+    // a 'zero' value (so may be initialized with random noise).
+    // NOTE: after the init_children() method, the children will be ordered by
+    // their à priori value `prior_value`.
+    static constexpr int CAPACITY = max_children<G>() + 1;    // Room for the MOVE_END sentinel.
+
+    using key_type      = typename G::key_type;
+    using cont_children = std::array<BasicActionNode<G>, CAPACITY>;
+public:
+    key_type            key                              = 0;           // Zobrist Hash of the state
+    int                 n_visits                         = 0;
+    int                 n_children                       = 0;
+    int                 n_expanded_children              = 0;           // Children considered by the selection, see widen().
+    Move                last_move                        = MOVE_NONE;
+    bool                best_known                       = false;       // Children values are exact.
+    Reward              value_sum                        = 0;           // Rewards backpropagated through the node, from all
+    int                 n_updates                        = 0;           // of its parents (pov of the player who moved into it).
+    uint32_t            generation                       = 0;           // Last search which reached the node.
+    int                 n_pending                        = 0;           // Paths through the node waiting for an evaluation.
+    uint32_t            compact_mark                     = 0;           // Scratch of compact() and evict(), 0 outside of them.
+    cont_children       children;
+
+    cont_children& children_list() { return children; }
+};
+
+template<Game G>
+inline bool operator==(const BasicNode<G>& a, const BasicNode<G>& b)
+{
+    return a.key == b.key;
+}
+
+// What malloc takes for a block of n bytes at most: rounded up to 16 bytes, plus
+// 16 bytes of its own header.
+constexpr size_t malloc_bytes(size_t n)
+{
+    return (n + 15) / 16 * 16 + 16;
+}
+
+// Bytes taken by the keyed table of a game, its nodes and its buckets, as counted
+// by its allocator.
+template<class G>
+inline size_t table_allocated = 0;
+
+template<class T, class G>
+struct TableAllocator {
+    using value_type = T;
+
+    TableAllocator() = default;
+    template<class U>
+    TableAllocator(const TableAllocator<U, G>&) { }
+
+    T* allocate(size_t n)
+    {
+        table_allocated<G> += malloc_bytes(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        table_allocated<G> -= malloc_bytes(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<class U>
+    bool operator==(const TableAllocator<U, G>&) const { return true; }
+};
+
+// The nodes of a game, by key. Each game has a table of its own, which outlives
+// the agents so that the next searches start from the previous trees.
+template<Game G>
+using BasicTable = std::unordered_map<typename G::key_type, BasicNode<G>,
+                                      std::hash<typename G::key_type>, std::equal_to<typename G::key_type>,
+                                      TableAllocator<std::pair<const typename G::key_type, BasicNode<G>>, G>>;
+
+template<Game G>
+inline BasicTable<G> game_table;
+
+// The tree below a root, rebuilt by BasicAgent::compact() into a contiguous block in
+// depth-first order, the most visited child first, so that the descents along the
+// principal variation stay within a few cache lines. Its edges point to their
+// children directly, the other lookups binary search the index. The nodes of the
+// arena aren't in game_table, and they aren't evicted.
+template<Game G>
+struct BasicArena {
+    using key_type = typename G::key_type;
+
+    std::vector<BasicNode<G>>                   nodes;
+    std::vector<std::pair<key_type, uint32_t>>  index;    // Sorted by key.
 
-    Agent(State& state);
+    BasicNode<G>* find(key_type key)
+    {
+        auto it = std::lower_bound(index.begin(), index.end(), std::make_pair(key, uint32_t(0)));
+        return it != index.end() && it->first == key ? nodes.data() + it->second : nullptr;
+    }
+
+    bool contains(const BasicNode<G>* node) const
+    {
+        return node >= nodes.data() && node < nodes.data() + nodes.size();
+    }
+
+    size_t size() const { return nodes.size(); }
+    void clear() { nodes.clear(); index.clear(); }
+};
+
+template<Game G>
+inline BasicArena<G> game_arena;
+
+// The nodes of an Indexable game by the index of their position, when the agents
+// use the direct table: a lookup is a single indexed load, with no hashing, and
+// no eviction. Allocated for the whole state space at the first search.
+template<Game G>
+inline std::vector<BasicNode<G>> direct_nodes;
+
+// Whether the searches of G keep their nodes in direct_nodes: the game must be
+// Indexable, and the whole array must fit in the memory budget if there is one
+// (the keyed table, which evicts, is used otherwise).
+template<Game G>
+bool uses_direct_nodes()
+{
+    if constexpr (Indexable<G>)
+        return AgentBase::direct_table && (!AgentBase::max_bytes || G::INDEX_SIZE * sizeof(BasicNode<G>) <= AgentBase::max_bytes);
+    else
+        return false;
+}
+
+// Tic-tac-toe, the game of the tools, the snapshots and the evaluators.
+using ActionNode = BasicActionNode<State>;
+using Node = BasicNode<State>;
+
+typedef BasicTable<State> MCTSLookupTable;
+
+inline MCTSLookupTable& MCTS = game_table<State>;
+
+
+// What a search reports while it runs, see anytime.h.
+struct SearchInfo {
+    Move                               best_move  = MOVE_NONE;
+    int                                iterations = 0;
+    long long                          elapsed_ms = 0;
+    std::vector<std::pair<Move, int>>  root_visits;    // Visits of each move of the root.
+    std::vector<Move>                  pv;             // Principal variation, by the final policy.
+};
+
+/**
+ * The search itself, on any Game. The selection policy scores the edges during the
+ * descents and the final policy picks the move to play, see policy.h.
+ *
+ * The members are defined in mcts.cpp, explicitly instantiated for each game and
+ * pair of policies. Those only making sense for tic-tac-toe (the batched evaluation,
+ * the perfect table, the snapshots and the shared table) are left out of the others.
+ */
+template<Game G = State, class Selection = Policy::UCB1, class Final = Policy::MostVisits>
+class BasicAgent : public AgentBase {
+
+public:
+    using Node       = BasicNode<G>;
+    using ActionNode = BasicActionNode<G>;
+    using Data       = typename G::Data;
+
+    static constexpr bool is_tictactoe = std::is_same_v<G, State>;
+    static constexpr bool is_indexable = Indexable<G>;
+
+    static constexpr int MAX_PLY = G::MAX_GAME_PLY + 3;
+    static constexpr int MAX_CHILDREN = Node::CAPACITY;
+
+    // Memory used by the nodes (the keyed table, the arena, the direct table and the
+    // eviction's scratch space), and the number of nodes the keyed table can hold
+    // within max_bytes.
+    static size_t table_bytes();
+    static size_t max_nodes();
+    static bool uses_direct_table() { return uses_direct_nodes<G>(); }
+    static void clear_table();
+
+    BasicAgent(G& state);
+    ~BasicAgent();
 
     Move MCTSBestMove();
 
     void create_root();
     bool computation_resources();
-    Node* tree_policy();
+    void iterate(ActionNode* first = nullptr);
+    Node* tree_policy(ActionNode* first = nullptr);
     Reward rollout_policy(Node* node);
-    void backpropagate(Node* node, Reward r);
+    void backpropagate(Node* node, Reward r, int weight = 1);
+    int playouts_at(int depth) const;
+    int widening_at(int n_visits) const;
+    void widen(Node* node);
 
     ActionNode* best_uct(Node* node);
+    ActionNode* best_final(Node* node);
     ActionNode* best_visits(Node* node);
     ActionNode* best_avg_val(Node* node);
+    Reward child_value(const ActionNode* action);
+    Node* child_hint(const ActionNode* action);
+    // Only from the edge's hint or direct table slot: in the keyed table, a child
+    // not reached yet through its edge (or evicted since) isn't prefetched.
+    void prefetch_child(const ActionNode* action);
 
     Node* current_node();
     bool is_root(Node* root);
     bool is_terminal(Node* node);
     void apply_move(Move move);
-    void apply_move(Move move, StateData& sd);
+    void apply_move(Move move, Data& sd);
     void undo_move();
     void undo_move(Move move);
     void init_children();
 
     Reward random_simulation(Move move);
+    Reward evaluate_move(Move move, bool exact, int empty_cells);
+    void batch_priors(Node* node, int n) requires is_tictactoe;
+    Reward batch_playouts(int k) requires is_tictactoe;
+    Reward alpha_beta(Reward alpha, Reward beta, int depth);
     Reward evaluate_terminal();
 
-    // Wether to backpropagate the minmax value of nodes or the rollout reward.
-    static void set_backpropagate_minimax(bool);
+    void make_room();
+    static void reserve_budget();
+    void evict(size_t target);
+    size_t compact();    // Between the moves, by the callers setting compact_tree.
+    int evictions() const { return evicted_cnt; }
+
+    void search_batched() requires is_tictactoe;
+    ActionNode* sequential_halving();
+    bool collect_batch(Batch& batch) requires is_tictactoe;
+    void apply_batch(Batch& batch) requires is_tictactoe;
+
+    // Anytime search: stop() ends the running MCTSBestMove after its current iteration
+    // (and the next ones until clear_stop()), and best_so_far() is kept up to date during
+    // the search. Both are thread safe. The update callback is called from the search
+    // thread every period_ms.
+    void stop() { stop_requested.store(true, std::memory_order_relaxed); }
+    void clear_stop() { stop_requested.store(false, std::memory_order_relaxed); }
+    Move best_so_far() const { return best_move.load(std::memory_order_relaxed); }
+    void reset_best_move();    // A legal move of the position, before the search publishes its own.
+    void set_update(std::function<void(const SearchInfo&)> callback, int period_ms);
+    SearchInfo info();
 
     // Debugging
     void print_node(std::ostream&, Node*) const;
     void print_tree(std::ostream&, int depth) const;
-    static void set_exp_c(double c);
-    static void set_max_time(int t);
-    static void set_max_iter(int i);
-    static inline bool debug_counters      = true;
-    static inline bool debug_main_methods  = false;
-    static inline bool debug_tree          = false;
-    static inline bool debug_best_visits   = false;
-    static inline bool debug_init_children = false;
-    static inline bool debug_random_sim    = false;
 
 private:
-    State& state;
+    G&      state;
     Node*   root;
 
     int ply;
+    int root_ply;
+    int rollout_weight;    // Number of playouts behind the last value of rollout_policy().
     int iteration_cnt;
 
     int rollout_cnt;
     int descent_cnt;
     int explored_nodes_cnt;
+    int solved_nodes_cnt;
+    int evicted_cnt;
 
     // To keep track of nodes during the search (indexed by ply)
     std::array<Node*, MAX_PLY>       nodes;       // The nodes.
     std::array<ActionNode*, MAX_PLY> actions;     // The actions.
-    std::array<StateData, MAX_PLY>   states;      // Utility allowing state to do and undo actions.
+    std::array<Data, MAX_PLY>        states;      // Utility allowing state to do and undo actions.
     std::array<Search::Stack, MAX_PLY> stackBuf;  // Allows to perform independant without creading nodes.
-};
 
-struct ActionNode {
-    Move                move;
-    int                 n_visits;
-    Reward              prior_value;
-    Reward              action_value;
-    double              avg_action_value;
-    bool                decisive;                // If it is a known win etc...
-};
+    HashTable<ABEntry, 4096> ab_table;            // Exact values of the positions solved at the leaves.
 
-struct Node {
-    // Careful when iterating through children, an ActionNode object doesn't have
-    // a 'zero' value (so may be initialized with random noise).
-    // NOTE: after the init_children() method, the children will be ordered by
-    // their à priori value `prior_value`.
-    using cont_children = std::array<ActionNode, Agent::MAX_CHILDREN>;
-public:
-    Key                 key                              = 0;           // Zobrist Hash of the state
-    int                 n_visits                         = 0;
-    int                 n_children                       = 0;
-    int                 n_expanded_children              = 0;
-    Move                last_move                        = MOVE_NONE;
-    bool                best_known;
-    cont_children       children;
+    std::vector<Playout::Board> playout_boards;   // Reused by the batched playouts.
+    std::vector<Reward>         playout_values;
 
-    cont_children& children_list() { return children; }
-};
+    std::mt19937 rng { std::random_device{}() };  // For the randomized selection policies.
 
-inline bool operator==(const Node& a, const Node& b)
-{
-    return a.key == b.key;
-}
+    std::unique_ptr<AsyncEvaluator> async;        // The evaluator's thread, from the first batched search on.
+
+    Trace::Ring* tracer = nullptr;                // The thread's ring during a traced search.
+
+    void publish();
+
+    std::atomic<bool> stop_requested { false };
+    std::atomic<Move> best_move { MOVE_NONE };
+    Move halving_leader = MOVE_NONE;          // The halving's choice so far, the one published.
+    std::function<void(const SearchInfo&)> on_update;
+    int update_period = 0;
+    long long next_update = 0;
+
+    std::optional<SearchInfo> cached_info;    // What info() reports after an answer of decision_cache.
+    void reset_counters();
+};
 
-typedef std::unordered_map<Key, Node> MCTSLookupTable;
+using Agent = BasicAgent<>;
 
-extern MCTSLookupTable MCTS;
+template<Game G>
+using GameAgent = BasicAgent<G>;
 
 }  // namespace mcts
 
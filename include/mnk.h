@@ -0,0 +1,163 @@
+#ifndef __MNK_H_
+#define __MNK_H_
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include "tictactoe.h"
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * A board of `Bits` squares, on as many 64-bit words as it takes. The shifts
+ * move the stones toward the higher squares for a positive d, and drop those
+ * going past either end of the board.
+ */
+template<int Bits>
+struct Bitboard {
+    static constexpr int WORDS = (Bits + 63) / 64;
+
+    std::array<uint64_t, WORDS> w {};
+
+    bool test(int i) const { return w[i >> 6] >> (i & 63) & 1; }
+    void set(int i)        { w[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(int i)      { w[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    bool any() const {
+        for (auto x : w)
+            if (x) return true;
+        return false;
+    }
+
+    int count() const {
+        int n = 0;
+        for (auto x : w)
+            n += std::popcount(x);
+        return n;
+    }
+
+    Bitboard operator|(const Bitboard& o) const { Bitboard r; for (int i=0; i<WORDS; ++i) r.w[i] = w[i] | o.w[i]; return r; }
+    Bitboard operator&(const Bitboard& o) const { Bitboard r; for (int i=0; i<WORDS; ++i) r.w[i] = w[i] & o.w[i]; return r; }
+
+    Bitboard shifted(int d) const {
+        Bitboard r;
+        int words = (d < 0 ? -d : d) >> 6, bits = (d < 0 ? -d : d) & 63;
+
+        for (int i=0; i<WORDS; ++i)
+        {
+            int j = d > 0 ? i - words : i + words;    // Word of w shifted into r.w[i].
+            if (j < 0 || j >= WORDS)
+                continue;
+
+            if (d > 0)
+            {
+                r.w[i] = w[j] << bits;
+                if (bits && j > 0)
+                    r.w[i] |= w[j - 1] >> (64 - bits);
+            }
+            else
+            {
+                r.w[i] = w[j] >> bits;
+                if (bits && j + 1 < WORDS)
+                    r.w[i] |= w[j + 1] << (64 - bits);
+            }
+        }
+        return r;
+    }
+};
+
+/**
+ * The m,n,k-games: M rows, N columns, and the first to align K stones wins (Gomoku
+ * is 15,15,5, and tic-tac-toe 3,3,3). It is made and unmade like State, with the
+ * same StateData records and status bits in the keys.
+ *
+ * The stones are on multi-word bitboards, row by row with a sentinel column at the
+ * end of each row so that the lines found with the shifts don't wrap around. Moves
+ * are the squares, Move(1 + row * N + col), the side being the player to move.
+ *
+ * Every square is a child of the nodes, in the order of prior(), a cheap locality
+ * score (the stones around the square). With the progressive widening of the agent,
+ * a node only evaluates the likeliest ones at first, and lets the next ones in as
+ * its visits grow, down to the last square of the board.
+ */
+template<int M, int N, int K>
+class MNKGame {
+    public:
+    static constexpr int ROWS = M;
+    static constexpr int COLS = N;
+    static constexpr int STRIDE = N + 1;            // Bits per row, with the sentinel.
+    static constexpr int BITS = M * STRIDE;
+
+    using bitboard_t = Bitboard<BITS>;
+    using key_type = Key;
+    using Data = StateData;
+
+    static constexpr int MAX_MOVES = M * N;
+    static constexpr int MAX_GAME_PLY = M * N;
+
+    MNKGame();
+    // A copy starts from the position of the original, its moves can't be undone.
+    MNKGame(const MNKGame&);
+    MNKGame& operator=(const MNKGame&);
+
+    // Game logic
+    Token winner() const;
+    Token next_player() const;
+    bool is_full() const;
+    bool is_terminal() const;
+    bool is_draw() const;
+    bool is_valid(Move move) const;
+    std::vector<Move>& valid_actions();
+    void apply_move(Move, StateData&);
+    void undo_move(Move);
+
+    static bool terminal(const StateData&);
+    static Reward terminal_value(const StateData&);
+
+    // A priori value of a move in [0, 1], higher for the moves next to the stones.
+    Reward prior(Move) const;
+
+    // Zobrist keys
+    Key key() const;
+    Key key_after(Move) const;                  // Key of the state after the move, without making it.
+
+    StateData* data;
+    int gamePly = 1;
+
+    const bitboard_t& board(Token) const;       // Stones of a player.
+    Token at(int row, int col) const;
+
+    static int moveToSquare(Move m);
+    static Move rowColToMove(int row, int col);
+
+    // K in a row among the stones.
+    static bool is_win(const bitboard_t& stones);
+
+private:
+    bool wins_with(Token, int square) const;    // The stone would make K in a row.
+
+    std::array<bitboard_t, 2> m_board {};       // Indexed by Token - 1.
+    std::vector<Move> m_valid_actions;
+    StateData m_start;                          // The data of the starting position.
+
+    static constexpr auto KEYS = Zobrist::make_square_keys<2 * BITS>(3241 + 97 * M + 31 * N + K);
+};
+
+using Gomoku = MNKGame<15, 15, 5>;
+
+template<int M, int N, int K>
+inline bool MNKGame<M, N, K>::terminal(const StateData& sd) {
+    return key_terminal(sd.key);
+}
+
+template<int M, int N, int K>
+inline Reward MNKGame<M, N, K>::terminal_value(const StateData& sd) {
+    return key_ev_terminal(sd);
+}
+
+} // namespace mcts
+
+
+#endif // __MNK_H_
@@ -0,0 +1,39 @@
+#ifndef __PLAYOUT_H_
+#define __PLAYOUT_H_
+
+#include <cstdint>
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * Random playouts of many tic-tac-toe boards at once. A board is the two 9-bit
+ * masks of the stones (bit i for the cell i), and eight of them go through the
+ * AVX2 lanes together: pick a random empty cell in every lane, place the stones,
+ * test the eight win lines in every lane, until all the lanes are over.
+ *
+ * The kernel is chosen at run time, the scalar one when the CPU has no AVX2.
+ * Both give the same results from the same seed: the board i draws its cells
+ * from its own generator, seeded from (seed, i).
+ */
+namespace Playout {
+
+    struct Board {
+        uint16_t to_move;       // Stones of the player to move.
+        uint16_t moved;         // Stones of the player who just moved.
+    };
+
+    // The value of n playouts, one from each board, for the player to move in
+    // it: 1 for a win, 0.5 for a draw, 0 for a loss (or if the board is already lost).
+    void run(const Board* boards, int n, Reward* values, uint64_t seed);
+
+    void run_scalar(const Board* boards, int n, Reward* values, uint64_t seed);
+    void run_avx2(const Board* boards, int n, Reward* values, uint64_t seed);
+
+    bool has_avx2();
+
+}  // namespace Playout
+
+}  // namespace mcts
+
+#endif // __PLAYOUT_H_
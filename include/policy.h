@@ -0,0 +1,92 @@
+#ifndef __POLICY_H_
+#define __POLICY_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * Selection and final move policies, given as template parameters to the
+ * agent so the inner loop is resolved at compile time.
+ *
+ * A selection policy scores an edge from its parent node, the edge's
+ * statistics and its mean value `q` (which the agent may read from the
+ * child node in graph mode). `c` is the agent's exploration constant,
+ * or its PUCT constant for the policies using priors. When visit_all_first
+ * is set, the children never visited are tried first, in prior order.
+ */
+namespace Policy {
+
+struct UCB1 {
+    static constexpr bool visit_all_first = true;
+    static constexpr bool uses_priors     = false;
+
+    template<class N, class E, class Rng>
+    static double score(const N& node, const E& edge, Reward q, double c, Rng&) {
+        return q + c * std::sqrt(2 * std::log(node.n_visits) / (edge.n_visits + 1));
+    }
+};
+
+// UCB1 with the exploration scaled by an upper bound on the variance of the rewards.
+struct UCB1Tuned {
+    static constexpr bool visit_all_first = true;
+    static constexpr bool uses_priors     = false;
+
+    template<class N, class E, class Rng>
+    static double score(const N& node, const E& edge, Reward q, double c, Rng&) {
+        double n     = edge.n_visits;
+        double log_n = std::log(node.n_visits);
+        double mean  = edge.action_value / n;
+        double var   = edge.sq_action_value / n - mean * mean + std::sqrt(2 * log_n / n);
+
+        return q + c * std::sqrt(log_n / n * std::min(0.25, var));
+    }
+};
+
+// Sample from the Beta posterior of the edge's mean reward.
+struct Thompson {
+    static constexpr bool visit_all_first = false;
+    static constexpr bool uses_priors     = false;
+
+    template<class N, class E, class Rng>
+    static double score(const N&, const E& edge, Reward q, double, Rng& rng) {
+        double n = edge.n_visits;
+        std::gamma_distribution<double> ga(1 + q * n), gb(1 + (1 - q) * n);
+        double a = ga(rng), b = gb(rng);
+
+        return a / (a + b);
+    }
+};
+
+// AlphaZero style, with the priors given by an Evaluator.
+struct PUCT {
+    static constexpr bool visit_all_first = false;
+    static constexpr bool uses_priors     = true;
+
+    template<class N, class E, class Rng>
+    static double score(const N& node, const E& edge, Reward q, double c, Rng&) {
+        return q + c * edge.policy * std::sqrt((double)node.n_visits) / (1 + edge.n_visits);
+    }
+};
+
+/**
+ * A final move policy scores the root's edges once the search is over.
+ */
+struct MostVisits {
+    template<class E>
+    static double score(const E& edge) { return edge.n_visits; }
+};
+
+struct BestValue {
+    template<class E>
+    static double score(const E& edge) { return edge.n_visits > 0 ? edge.avg_action_value : -1.0; }
+};
+
+} // namespace Policy
+
+} // namespace mcts
+
+#endif // __POLICY_H_
@@ -0,0 +1,169 @@
+#ifndef __RECORDS_H_
+#define __RECORDS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mcts.h"
+
+namespace mcts {
+
+/**
+ * Self-play games on disk, one fixed-size GameRecord per game: its moves, the
+ * visits of the root's moves at each of them, the result and the search counters.
+ *
+ * A RecordWriter takes the records from any number of threads, each one filling
+ * its own Buffer, which hands over whole blocks of records. A background thread
+ * compresses the blocks (when asked to) and writes them, so the games never wait
+ * on the disk. A RecordReader maps the file: the records of an uncompressed file
+ * are read in place, with no parsing; those of a compressed one are decoded a
+ * block at a time.
+ *
+ * The file is a Header then, uncompressed, the records; compressed, the blocks,
+ * each one a BlockHeader then its records encoded by Records::compress().
+ */
+struct GameRecord {
+    static constexpr int MAX_PLIES = State::MAX_GAME_PLY;
+
+    struct Ply {
+        int8_t   cell;                          // The move played.
+        uint8_t  padding[3];
+        int32_t  visits[9];                     // Visits of the root's moves, by cell.
+    };
+
+    uint8_t   n_plies = 0;
+    int8_t    winner = TOK_EMPTY;               // TOK_EMPTY for a draw.
+    uint8_t   padding[2] {};
+    uint32_t  iterations = 0;                   // Over all the searches of the game.
+    uint64_t  elapsed_us = 0;
+    Ply       plies[MAX_PLIES] {};
+
+    // Records a move, with the visits of the search which chose it.
+    void add(Move move, const SearchInfo& si);
+};
+
+namespace Records {
+
+    constexpr uint32_t VERSION = 1;
+
+    enum Codec : uint32_t { CODEC_NONE, CODEC_ZERO_RLE };
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t codec;
+        uint32_t block_records;                 // Records per block, the last one may have less.
+        uint64_t n_records;                     // 0 if the writer wasn't closed.
+    };
+
+    struct BlockHeader {
+        uint32_t n_records;
+        uint32_t stored_size;                   // Bytes following the header.
+    };
+
+    // Runs of zeros (most of the visits) as one byte. A control byte c < 128 is
+    // followed by c + 1 literal bytes, c >= 128 stands for c - 127 zeros.
+    void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+    bool decompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size);
+
+}  // namespace Records
+
+class RecordWriter {
+public:
+    static constexpr size_t BLOCK_RECORDS = 256;
+
+    // The records of one producing thread, handed to the writer by whole blocks,
+    // and the rest when the buffer is flushed or destroyed.
+    class Buffer {
+    public:
+        explicit Buffer(RecordWriter& writer);
+        ~Buffer();
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        void add(const GameRecord& record);
+        void flush();
+
+    private:
+        RecordWriter&           writer;
+        std::vector<GameRecord> records;
+    };
+
+    RecordWriter() = default;
+    ~RecordWriter();
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    // Create the file at `path` and start the I/O thread, false on failure.
+    bool open(const std::string& path, bool compress = false);
+
+    // Write what the buffers handed over, and stop the I/O thread. The buffers
+    // must have been flushed.
+    bool close();
+
+    bool is_open() const { return io.joinable(); }
+    uint64_t n_records() const { return n_written.load(std::memory_order_relaxed); }
+    uint64_t bytes_written() const { return n_bytes.load(std::memory_order_relaxed); }
+
+private:
+    void submit(std::vector<GameRecord>&& block);
+    void run();
+    void write_block(const std::vector<GameRecord>& block);
+
+    std::ofstream                        ofs;
+    Records::Header                      header {};
+    std::vector<uint8_t>                 encoded;    // Reused by the I/O thread.
+
+    std::mutex                           mtx;
+    std::condition_variable              cv;
+    std::deque<std::vector<GameRecord>>  queue;
+    bool                                 closing = false;
+    std::thread                          io;
+
+    std::atomic<uint64_t>                n_written { 0 };
+    std::atomic<uint64_t>                n_bytes { 0 };
+    bool                                 failed = false;
+};
+
+class RecordReader {
+public:
+    RecordReader() = default;
+    ~RecordReader();
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+
+    // Map the file at `path`, false if it is missing or invalid.
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return map != nullptr; }
+    bool compressed() const { return codec != Records::CODEC_NONE; }
+    size_t size() const { return n_records; }
+
+    // The next record, nullptr after the last one. It stays valid until the next
+    // call (in a compressed file, the block it is in is decoded in a buffer).
+    const GameRecord* next();
+    void rewind();
+
+private:
+    void*                   map = nullptr;
+    size_t                  map_size = 0;
+    uint32_t                codec = Records::CODEC_NONE;
+    size_t                  n_records = 0;
+
+    size_t                  offset = 0;    // Of the next block in the file (compressed).
+    const GameRecord*       cur = nullptr;
+    const GameRecord*       cur_end = nullptr;
+    std::vector<GameRecord> block;
+};
+
+}  // namespace mcts
+
+#endif // __RECORDS_H_
@@ -0,0 +1,20 @@
+#ifndef __SEARCH_H_
+#define __SEARCH_H_
+
+#include "type.h"
+
+namespace mcts {
+namespace Search {
+
+// What a random simulation keeps of each ply, so that it can undo its moves
+// without creating nodes.
+struct Stack {
+    Move    currentMove;
+    int     ply;
+    Reward  r;
+};
+
+}  // namespace Search
+}  // namespace mcts
+
+#endif // __SEARCH_H_
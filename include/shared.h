@@ -0,0 +1,88 @@
+#ifndef __SHARED_H_
+#define __SHARED_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "mcts.h"
+
+namespace mcts {
+
+/**
+ * Edge statistics kept in a named POSIX shared memory segment, so that several
+ * processes search together: each one backpropagates into the segment as well
+ * as into its own tree, and reads the sums of all of them when selecting.
+ *
+ * The tree itself (priors, children order, child hints) stays in each process'
+ * table. Entries are claimed by compare-and-swap on their key and edges on their
+ * move, the counters are atomic adds, so there is no lock anywhere: a reader may
+ * see the visits of an update before its value, which the search tolerates just
+ * as it tolerates virtual visits. When the probed entries of a position are all
+ * taken, its updates are only local.
+ */
+class SharedTable {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr Key      FREE    = ~Key(0);    // Key of an unclaimed entry.
+    static constexpr int      PROBES  = 8;
+
+    struct Edge {
+        std::atomic<int32_t>  move;                 // MOVE_NONE until claimed.
+        std::atomic<int32_t>  n_visits;
+        std::atomic<double>   action_value;
+        std::atomic<double>   sq_action_value;
+    };
+
+    struct Entry {
+        std::atomic<Key>      key;
+        Edge                  edges[Agent::MAX_CHILDREN];
+    };
+
+    struct Header {
+        char                  magic[8];
+        uint32_t              version;
+        uint32_t              max_children;
+        uint64_t              n_entries;
+        std::atomic<uint32_t> ready;                // Set once the creator initialized the entries.
+    };
+
+    static_assert(std::atomic<Key>::is_always_lock_free);
+    static_assert(std::atomic<int32_t>::is_always_lock_free);
+    static_assert(std::atomic<double>::is_always_lock_free);
+
+    SharedTable() = default;
+    ~SharedTable();
+    SharedTable(const SharedTable&) = delete;
+    SharedTable& operator=(const SharedTable&) = delete;
+
+    // Attach to the segment `name` (like "/mcts"), creating it with room for
+    // n_entries positions (rounded up to a power of two) if it doesn't exist.
+    bool open(const std::string& name, size_t n_entries = 1 << 15);
+    void close();
+    static bool unlink(const std::string& name);
+
+    bool is_open() const { return entries != nullptr; }
+    size_t capacity() const { return n_entries; }
+    size_t size() const;    // Positions claimed so far.
+
+    // Adds `weight` visits and their rewards to the edge `move` of the position.
+    void add(Key key, Move move, int weight, Reward value, Reward sq_value);
+
+    // Overwrites the statistics of the node's edges with the shared ones, plus
+    // the edges' own pending virtual visits, false if no process updated the
+    // position yet.
+    bool load(Node& node) const;
+
+private:
+    Entry* find(Key key, bool insert) const;
+    static Edge* find_edge(Entry& entry, Move move, bool insert);
+
+    Entry*  entries   = nullptr;
+    size_t  n_entries = 0;
+    void*   map       = nullptr;
+    size_t  map_size  = 0;
+};
+
+} // namespace mcts
+
+#endif // __SHARED_H_
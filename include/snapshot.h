@@ -0,0 +1,92 @@
+#ifndef __SNAPSHOT_H_
+#define __SNAPSHOT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mcts.h"
+
+namespace mcts {
+
+/**
+ * A flat, position independent image of the search tree on disk.
+ *
+ * The file is a Header followed by Records sorted by key, with fixed width
+ * fields only, so it can be mmap'ed read-only and binary searched in place.
+ * Nothing is deserialized at startup: get_node() copies a record into the
+ * live table the first time the search reaches its position, and several
+ * processes can share the same page-cached file.
+ */
+class Snapshot {
+public:
+    static constexpr uint32_t VERSION = 4;
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t max_children;
+        uint64_t n_records;
+    };
+
+    struct Edge {
+        int32_t  move;
+        int32_t  n_visits;
+        double   prior_value;
+        double   action_value;
+        double   avg_action_value;
+        double   sq_action_value;
+        uint8_t  decisive;
+        uint8_t  padding[3];
+        float    policy;
+    };
+
+    struct Record {
+        uint64_t key;
+        int32_t  n_visits;
+        int32_t  n_children;
+        double   value_sum;
+        int32_t  n_updates;
+        uint8_t  padding[4];
+        Edge     children[Agent::MAX_CHILDREN];
+    };
+
+    Snapshot() = default;
+    ~Snapshot();
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Write the nodes of the table, the arena and the direct table to `path`,
+    // return false on failure.
+    static bool save(const std::string& path, const MCTSLookupTable& table = MCTS,
+                     const BasicArena<State>& arena = game_arena<State>,
+                     const std::vector<Node>& direct = direct_nodes<State>);
+
+    // Map the file at `path`, return false if it is missing or invalid.
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return records != nullptr; }
+    size_t size() const { return n_records; }
+    const Record* begin() const { return records; }
+    const Record* end() const { return records + n_records; }
+
+    // Binary search for a position, nullptr if it isn't in the snapshot.
+    const Record* find(Key key) const;
+
+    static void to_node(const Record&, Node&);
+    static void to_record(const Node&, Record&);
+
+private:
+    void*         map      = nullptr;
+    size_t        map_size = 0;
+    const Record* records  = nullptr;
+    size_t        n_records = 0;
+};
+
+static_assert(sizeof(Snapshot::Header) == 24);
+static_assert(sizeof(Snapshot::Edge) == 48);
+static_assert(sizeof(Snapshot::Record) == 32 + 48 * Agent::MAX_CHILDREN);
+
+} // namespace mcts
+
+#endif // __SNAPSHOT_H_
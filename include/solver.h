@@ -0,0 +1,84 @@
+#ifndef __SOLVER_H_
+#define __SOLVER_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "tictactoe.h"
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * Perfect play table for tic-tac-toe.
+ *
+ * A grid is mapped to its base-3 index sum(token * 3^cell), which is a
+ * perfect hash of the 3^9 = 19683 encodings. Every reachable position is
+ * solved by retrograde analysis (from the full boards back to the empty
+ * one) and its game theoretic value, from the point of view of the side
+ * to move, is stored on 2 bits.
+ */
+namespace Solver {
+
+enum Value : uint8_t {
+    VALUE_NONE = 0,    // Unreachable encoding.
+    VALUE_LOSS = 1,
+    VALUE_DRAW = 2,
+    VALUE_WIN  = 3
+};
+
+constexpr int N_POSITIONS = 19683;
+constexpr int TABLE_BYTES = (N_POSITIONS + 3) / 4;
+
+// The value for the side who just moved into a position of value `v`.
+constexpr Value flip(Value v) {
+    return v == VALUE_NONE ? VALUE_NONE : Value(VALUE_WIN + VALUE_LOSS - v);
+}
+
+// As a Reward (1 for a win, 0.5 for a draw, 0 for a loss).
+constexpr Reward to_reward(Value v) {
+    return (v - VALUE_LOSS) * 0.5;
+}
+
+class Table {
+public:
+    Table() = default;
+    ~Table();
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    // Solve all positions in memory, splitting each layer between threads.
+    void solve(int n_threads = 0);
+
+    // Write the 2-bit table to `path`, or map one previously written.
+    bool save(const std::string& path) const;
+    bool open(const std::string& path);
+
+    bool is_ready() const { return bits != nullptr; }
+
+    Value value(int index) const {
+        return Value((bits[index >> 2] >> ((index & 3) << 1)) & 3);
+    }
+    Value value(const State& state) const { return value(state.index()); }
+
+    // Exact reward of `move`, from the point of view of the player making it.
+    Reward reward(const State& state, Move move) const;
+
+    // A move preserving the value of the position (MOVE_NONE if terminal).
+    Move best_move(State& state) const;
+
+    // Whether `move` keeps the game theoretic value of the position.
+    bool is_perfect(State& state, Move move) const;
+
+private:
+    std::array<uint8_t, TABLE_BYTES> storage {};
+    const uint8_t* bits = nullptr;
+    void*          map  = nullptr;
+    size_t         map_size = 0;
+};
+
+} // namespace Solver
+
+} // namespace mcts
+
+#endif // __SOLVER_H_
@@ -2,7 +2,8 @@
 #define __TICTACTOE_H_
 
 #include <array>
-#include <list>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include "type.h"
 
@@ -25,10 +26,18 @@ struct StateData {
 class State {
     public:
     using grid_t = std::array<Token, 9>;
+    using key_type = Key;
+    using Data = StateData;
 
-    static void init();
+    static constexpr int MAX_MOVES = 9;
+    static constexpr int MAX_GAME_PLY = 9;
+    static constexpr int INDEX_SIZE = 19683;    // 3^9
+    static constexpr std::array<int, 9> POW3 = { 1, 3, 9, 27, 81, 243, 729, 2187, 6561 };
 
     State();
+    // A copy starts from the position of the original, its moves can't be undone.
+    State(const State&);
+    State& operator=(const State&);
     // explicit State(const grid_t&);
     // explicit State(grid_t&&);
     // Game logic
@@ -42,14 +51,25 @@ class State {
     void apply_move(Move, StateData&);
     void undo_move(Move);
 
+    // Status of the position of a StateData, see key_terminal() and key_ev_terminal().
+    static bool terminal(const StateData&);
+    static Reward terminal_value(const StateData&);
+
     // Zobrist keys
     Key key() const;
+    Key key_after(Move) const;                  // Key of the state after the move, without making it.
+
+    // Exact index of the position, the sum of token * 3^cell over the cells.
+    int index() const;
+    int index_after(Move) const;
+    static int index(const grid_t&);
 
     StateData* data;
     int gamePly = 1;
 
+    uint16_t stones(Token) const;               // Bit i set for the cells i of the player.
     const grid_t& grid() const;                 // Only for testing.
-    const std::list<Cell>& empty_cells() const; // Only for testing
+    std::vector<Cell> empty_cells() const;      // Only for testing
 
     static Token moveToToken(Move m);
     static Cell moveToCell(Move m);
@@ -58,16 +78,83 @@ class State {
 private:
     static const std::array<std::array<enum Cell, 3>, 8> WIN_LINES;
     grid_t m_grid;
-    std::list<Cell> m_empty_cells;
+    uint16_t m_empty = 0x1FF;                   // Bit i set while the cell i is empty.
     std::vector<Move> m_valid_actions;
-
+    int m_index = 0;
+    StateData m_start;                          // The data of the starting position.
 
 };
 
+namespace Zobrist {
+
+    /**
+     * xorshift64star pseudo-random generator (as in Stockfish), usable in
+     * constant expressions so the keys are the same in every build and
+     * every process, and don't need to be initialized at run time.
+     */
+    class PRNG {
+        uint64_t s;
+
+    public:
+        constexpr explicit PRNG(uint64_t seed) : s(seed) { }
+
+        constexpr uint64_t rand() {
+            s ^= s >> 12, s ^= s << 25, s ^= s >> 27;
+            return s * 2685821657736338717ULL;
+        }
+    };
+
+    constexpr std::array<Key, 19> make_keys(uint64_t seed) {
+        PRNG rng(seed);
+        std::array<Key, 19> keys { 0 };     // First entry will be 0, for the Empty initial state
+
+        for (int i=1; i<19; ++i)
+        {
+            keys[i] = ((rng.rand() >> 3) << 3);    // Least three significant bits are reserved.
+        }
+        return keys;
+    }
+
+    // Keys of the squares of a board, for the games other than tic-tac-toe.
+    template<std::size_t Size>
+    constexpr std::array<Key, Size> make_square_keys(uint64_t seed) {
+        PRNG rng(seed);
+        std::array<Key, Size> keys { 0 };
+
+        for (auto& k : keys)
+            k = ((rng.rand() >> 3) << 3);       // Least three significant bits are reserved.
+        return keys;
+    }
+
+    inline constexpr std::array<Key, 19> ndx_keys = make_keys(1070372);
+
+    constexpr Key moveKey(Move move) {
+        return ndx_keys[move];
+    }
+
+    constexpr Key terminalKey = 1;
+    constexpr Key sideKey = 2;
+    constexpr Key drawKey = 4;
+
+}  // namespace Zobrist
+
 inline bool key_terminal(Key key) {
     return key & 1;
 }
 
+// The status part of the key after a move: first bit if the game is over, third if drawn.
+inline Key status_bits(bool win, bool full) {
+    return Key(win || full) | Key(full && !win) << 2;
+}
+
+// A copy of a position starts from it: its start data is the current data of
+// the position copied, without the history. Returns the copy's data.
+inline StateData* start_from(StateData& start, const StateData& current) {
+    start = current;
+    start.previous = nullptr;
+    return &start;
+}
+
 inline Token key_next_player(Key key) {
     return Token(1 + (key >> 1 & 1));
 }
@@ -83,6 +170,14 @@ inline double key_ev_terminal(StateData sd) {
                              : 1;     // either it is a draw or a win (reflect token in backpropagation)
 }
 
+inline bool State::terminal(const StateData& sd) {
+    return key_terminal(sd.key);
+}
+
+inline Reward State::terminal_value(const StateData& sd) {
+    return key_ev_terminal(sd);
+}
+
 } // namespace mcts
 
 
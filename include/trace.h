@@ -0,0 +1,116 @@
+#ifndef __TRACE_H_
+#define __TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "type.h"
+
+namespace mcts {
+
+/**
+ * Binary trace of the searches, for diagnosing them at full speed (the debug_*
+ * flags print whole boards and make the search hundreds of times slower).
+ *
+ * With Agent::trace_search, every iteration records a few fixed-size events in the
+ * ring of its thread: the edges selected, the leaf reached, the rollout value and
+ * the end of the backpropagation. Recording an event is a store in the ring and
+ * an increment, and the phase events read the steady clock. When the ring is full
+ * the oldest events are overwritten, so it holds the last searches.
+ *
+ * flush() writes the events to a file (a Header then the Events, oldest first),
+ * which tools/replay.cpp reads back to rebuild the paths, the value traces and
+ * the latencies of the phases.
+ */
+namespace Trace {
+
+    enum EventType : uint8_t {
+        EVENT_SEARCH,           // Start of MCTSBestMove, `value` is the root's visits.
+        EVENT_ITERATION,        // Start of a descent.
+        EVENT_SELECT,           // An edge of the descent, `edge` being its index in the node. Not timed.
+        EVENT_LEAF,             // End of the selection.
+        EVENT_ROLLOUT,          // End of the expansion and the playouts, `value` is the leaf's.
+        EVENT_BACKUP,           // End of the backpropagation.
+        EVENT_RESULT,           // End of MCTSBestMove, `move` is the move played.
+        EVENT_NB
+    };
+
+    struct Event {
+        uint64_t time_ns;       // Steady clock, 0 for the events which aren't timed.
+        uint32_t iteration;
+        float    value;
+        int16_t  move;
+        uint8_t  edge;
+        uint8_t  depth;         // Plies below the root.
+        uint8_t  type;
+        uint8_t  padding[3];
+    };
+
+    static_assert(sizeof(Event) == 24);
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t event_size;
+        uint64_t n_events;
+        uint64_t n_dropped;     // Events overwritten before the flush.
+    };
+
+    constexpr uint32_t VERSION = 1;
+
+    uint64_t now_ns();
+
+    // Written by a single thread. Another one may read it (events() and flush()),
+    // though the events recorded meanwhile can be torn: stop the search first.
+    class Ring {
+    public:
+        explicit Ring(size_t capacity = 1 << 16);    // Rounded up to a power of two.
+
+        void record(EventType type, uint32_t iteration, int depth,
+                    Move move = MOVE_NONE, int edge = 0, float value = 0)
+        {
+            uint64_t head = m_head.load(std::memory_order_relaxed);
+            Event& e = m_events[head & m_mask];
+
+            e.time_ns   = type == EVENT_SELECT ? 0 : now_ns();
+            e.iteration = iteration;
+            e.value     = value;
+            e.move      = move;
+            e.edge      = edge;
+            e.depth     = depth;
+            e.type      = type;
+
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+        size_t capacity() const { return m_mask + 1; }
+        uint64_t n_recorded() const { return m_head.load(std::memory_order_acquire); }
+        void clear() { m_head.store(0, std::memory_order_release); }
+
+        // The events still in the ring, oldest first.
+        std::vector<Event> events() const;
+
+        // Write them to `path`, return false on failure.
+        bool flush(const std::string& path) const;
+
+    private:
+        std::unique_ptr<Event[]> m_events;
+        size_t                   m_mask;
+        std::atomic<uint64_t>    m_head { 0 };
+    };
+
+    // The ring of the calling thread, allocated at the first call.
+    Ring& ring();
+
+    // Read a flushed trace, return false if the file is missing or invalid.
+    bool load(const std::string& path, std::vector<Event>& events, Header* header = nullptr);
+
+    const char* type_name(EventType);
+
+}  // namespace Trace
+
+}  // namespace mcts
+
+#endif // __TRACE_H_
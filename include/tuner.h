@@ -0,0 +1,74 @@
+#ifndef __TUNER_H_
+#define __TUNER_H_
+
+#include <array>
+#include <random>
+#include <vector>
+#include "mcts.h"
+
+namespace mcts {
+
+/**
+ * Automatic tuning of the Agent's search knobs by SPSA (simultaneous
+ * perturbation stochastic approximation) over self-play results.
+ *
+ * The objective is a penalty in [0, 1]: the proportion of games where the
+ * agent fails to play perfectly, i.e. loses against a random opponent
+ * or doesn't draw against itself.
+ */
+namespace Tuner {
+
+struct Params {
+    double exploration_cst   = 0.7;
+    bool   propagate_minimax = false;
+    int    n_rollouts        = 1;
+};
+
+struct Config {
+    int      max_iter       = 1000;   // Fixed iteration budget per move,
+    int      max_time       = 0;      // or fixed time budget (in ms) if positive.
+    int      n_steps        = 50;     // Number of SPSA iterations.
+    int      games_per_eval = 12;     // Games per evaluation of the objective.
+    double   a              = 0.2;    // Gain sequences a_k = a / (k + 1 + A)^alpha,
+    double   c              = 0.15;   //                c_k = c / (k + 1)^gamma.
+    double   A              = 5;
+    double   alpha          = 0.602;
+    double   gamma          = 0.101;
+    unsigned seed           = 0;
+    bool     verbose        = false;
+};
+
+// SPSA works on the unit cube, each coordinate being mapped to one knob. The
+// points out of the cube are clamped to it, the knobs out of their range too.
+using Point = std::array<double, 3>;
+
+constexpr double EXP_C_MIN    = 0.05;
+constexpr double EXP_C_MAX    = 3.0;
+constexpr int    ROLLOUTS_MAX = 16;
+
+Params to_params(const Point&);
+Point to_point(const Params&);
+
+// Read or set the knobs of the Agent.
+Params current();
+void apply(const Params&);
+
+// Play one game with the current knobs. The agent plays `side`, the other
+// side plays uniformly at random, or the agent plays both if `side` is TOK_EMPTY.
+Token play_game(Token side, std::mt19937& rng);
+
+// Penalty of a parameter set with the budget given by the config.
+double evaluate(const Params&, const Config&, unsigned seed);
+
+// Run SPSA from the given starting point and return the best parameters found.
+Params spsa(const Params& start, const Config&);
+
+// Tune at each budget (in increasing order) and return the first one whose tuned
+// parameters reach a zero penalty, or -1 if none does. `best` receives the parameters.
+int cheapest_budget(const std::vector<int>& budgets, const Params& start, Params& best, Config);
+
+} // namespace Tuner
+
+} // namespace mcts
+
+#endif // __TUNER_H_
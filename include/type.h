@@ -0,0 +1,33 @@
+#ifndef __TYPE_H_
+#define __TYPE_H_
+
+#include <cstdint>
+
+namespace mcts {
+
+typedef uint64_t Key;
+typedef double   Reward;    // In [0, 1], 1 being a win for the player concerned.
+
+// TOK_EMPTY is 0 so that the arrays of tokens start out empty.
+enum Token : int {
+    TOK_EMPTY = 0,
+    X         = 1,
+    O         = 2
+};
+
+// The cells of the tic-tac-toe board, 0 to 8 row by row.
+enum Cell : int {
+    CELL_NONE = -1
+};
+
+// The moves are numbered from 1 by each game (see State::cellTokenToMove(),
+// ConnectFour::columnToMove() and MNKGame::rowColToMove()). MOVE_END is past all
+// of them: it is the sentinel after the children of a node.
+enum Move : int {
+    MOVE_NONE = 0,
+    MOVE_END  = 0x7FFF
+};
+
+}  // namespace mcts
+
+#endif // __TYPE_H_
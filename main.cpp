@@ -0,0 +1,12 @@
+#include <iostream>
+#include "engine.h"
+
+using namespace mcts;
+
+int main()
+{
+    Engine engine;
+    engine.loop(std::cin);
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <ostream>
+#include "alloc.h"
+
+namespace mcts {
+
+namespace Alloc {
+
+namespace {
+
+    // Constant-initialized, so operator new can use them from the start of the thread.
+    thread_local Phase current = PHASE_OTHER;
+    thread_local Stats counters;
+
+    bool hooked = false;
+
+}  // namespace
+
+void record(size_t size)
+{
+    auto& c = counters.phases[current];
+    ++c.allocs;
+    c.bytes += size;
+}
+
+bool install()
+{
+    return hooked = true;
+}
+
+bool counting()
+{
+    return hooked;
+}
+
+Counters Stats::total() const
+{
+    Counters sum;
+    for (const auto& c : phases)
+    {
+        sum.allocs += c.allocs;
+        sum.bytes  += c.bytes;
+    }
+    return sum;
+}
+
+Stats Stats::operator-(const Stats& before) const
+{
+    Stats diff;
+    for (int p = 0; p < PHASE_NB; ++p)
+    {
+        diff.phases[p].allocs = phases[p].allocs - before.phases[p].allocs;
+        diff.phases[p].bytes  = phases[p].bytes  - before.phases[p].bytes;
+    }
+    return diff;
+}
+
+Stats stats()
+{
+    return counters;
+}
+
+const char* phase_name(Phase phase)
+{
+    switch (phase)
+    {
+        case PHASE_OTHER:           return "other";
+        case PHASE_SELECTION:       return "selection";
+        case PHASE_EXPANSION:       return "expansion";
+        case PHASE_SIMULATION:      return "simulation";
+        case PHASE_BACKPROPAGATION: return "backpropagation";
+        default:                    return "?";
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const Stats& stats)
+{
+    for (int p = 0; p < PHASE_NB; ++p)
+    {
+        const auto& c = stats.phases[p];
+        os << (p ? ", " : "") << phase_name(Phase(p)) << ' ' << c.allocs << " (" << c.bytes << " bytes)";
+    }
+    return os;
+}
+
+Scope::Scope(Phase phase)
+    : m_previous(current)
+{
+    current = phase;
+}
+
+Scope::~Scope()
+{
+    current = m_previous;
+}
+
+}  // namespace Alloc
+
+}  // namespace mcts
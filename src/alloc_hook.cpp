@@ -0,0 +1,40 @@
+#include <cstdlib>
+#include <new>
+#include "alloc.h"
+
+// The counting operator new, only linked into the binaries which report their
+// allocations (testAlloc, and every binary of the Debug builds or with
+// COUNT_ALLOCS on, see CMakeLists.txt): the others keep the library's own.
+
+namespace {
+
+    const bool installed = mcts::Alloc::install();
+
+}  // namespace
+
+//*************************** Replaced operator new ***************************/
+
+// The array and nothrow forms of the standard library call these ones.
+void* operator new(size_t size)
+{
+    mcts::Alloc::record(size);
+
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    mcts::Alloc::record(size);
+
+    size_t a = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept                          { std::free(p); }
+void operator delete(void* p, size_t) noexcept                  { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept        { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
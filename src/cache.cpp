@@ -0,0 +1,196 @@
+#include <algorithm>
+#include "cache.h"
+
+namespace mcts {
+
+namespace {
+
+    // SYMMETRY[s][c] is the image of the cell c by the symmetry s: the identity, the
+    // three rotations, the two reflections by the middle lines, and by the diagonals.
+    constexpr std::array<std::array<int, 9>, DecisionCache::SYMMETRIES> make_symmetries()
+    {
+        std::array<std::array<int, 9>, DecisionCache::SYMMETRIES> sym {};
+        for (int c = 0; c < 9; ++c)
+        {
+            int r = c / 3, k = c % 3;
+            sym[0][c] = 3 * r       + k;
+            sym[1][c] = 3 * k       + (2 - r);
+            sym[2][c] = 3 * (2 - r) + (2 - k);
+            sym[3][c] = 3 * (2 - k) + r;
+            sym[4][c] = 3 * r       + (2 - k);
+            sym[5][c] = 3 * (2 - r) + k;
+            sym[6][c] = 3 * k       + r;
+            sym[7][c] = 3 * (2 - k) + (2 - r);
+        }
+        return sym;
+    }
+
+    constexpr auto SYMMETRY = make_symmetries();
+
+    constexpr std::array<std::array<int, 9>, DecisionCache::SYMMETRIES> make_inverses()
+    {
+        std::array<std::array<int, 9>, DecisionCache::SYMMETRIES> inv {};
+        for (int s = 0; s < DecisionCache::SYMMETRIES; ++s)
+            for (int c = 0; c < 9; ++c)
+                inv[s][SYMMETRY[s][c]] = c;
+        return inv;
+    }
+
+    constexpr auto INVERSE = make_inverses();
+
+    // splitmix64's finalizer, so that the configurations spread over all the bits.
+    uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    Move map_move(Move move, const std::array<int, 9>& cells)
+    {
+        if (move == MOVE_NONE || move == MOVE_END)
+            return move;
+        return State::cellTokenToMove(Cell(cells[State::moveToCell(move)]), State::moveToToken(move));
+    }
+
+    // The moves of the decision by one of the tables.
+    DecisionCache::Decision map_decision(DecisionCache::Decision d, const std::array<int, 9>& cells)
+    {
+        d.move = map_move(d.move, cells);
+        for (int i = 0; i < d.n_children; ++i)
+            d.visits[i].first = map_move(d.visits[i].first, cells);
+        return d;
+    }
+
+}  // namespace
+
+DecisionCache::DecisionCache(size_t capacity, int n_shards)
+    : shards(std::max(1, n_shards))
+    , per_shard(std::max<size_t>(1, (capacity + shards.size() - 1) / shards.size()))
+{
+    for (auto& s : shards)
+        s.map.reserve(per_shard);
+}
+
+std::pair<int, int> DecisionCache::canonical(const State& state)
+{
+    const auto& grid = state.grid();
+    int best = -1, best_sym = 0;
+
+    for (int s = 0; s < SYMMETRIES; ++s)
+    {
+        int index = 0;
+        for (int c = 0; c < 9; ++c)
+            index += grid[c] * State::POW3[SYMMETRY[s][c]];
+
+        if (best < 0 || index < best)
+        {
+            best = index;
+            best_sym = s;
+        }
+    }
+    return { best, best_sym };
+}
+
+Move DecisionCache::transform(Move move, int symmetry)
+{
+    return map_move(move, SYMMETRY[symmetry]);
+}
+
+Move DecisionCache::inverse(Move move, int symmetry)
+{
+    return map_move(move, INVERSE[symmetry]);
+}
+
+uint64_t DecisionCache::policies_hash(const std::type_info& selection, const std::type_info& final)
+{
+    return mix(selection.hash_code()) ^ mix(final.hash_code() + 1);
+}
+
+size_t DecisionCache::KeyHash::operator()(const EntryKey& k) const
+{
+    return mix((uint64_t(k.index) << 32 | uint32_t(k.budget)) ^ mix(k.config));
+}
+
+// The high bits of the hash, the maps of the shards using the low ones.
+auto DecisionCache::shard(const EntryKey& key) -> Shard&
+{
+    return shards[(KeyHash()(key) >> 32) % shards.size()];
+}
+
+std::optional<DecisionCache::Decision> DecisionCache::find(const State& state, int budget, uint64_t config)
+{
+    auto [index, sym] = canonical(state);
+    EntryKey key { index, budget, config };
+    Shard& s = shard(key);
+
+    std::unique_lock<std::mutex> lock(s.mtx);
+
+    auto it = s.map.find(key);
+    if (it == s.map.end())
+    {
+        lock.unlock();
+        n_misses.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    Decision d = it->second->decision;
+    lock.unlock();
+
+    n_hits.fetch_add(1, std::memory_order_relaxed);
+    return map_decision(d, INVERSE[sym]);
+}
+
+void DecisionCache::insert(const State& state, int budget, const Decision& decision, uint64_t config)
+{
+    auto [index, sym] = canonical(state);
+    EntryKey key { index, budget, config };
+    Decision d = map_decision(decision, SYMMETRY[sym]);
+    Shard& s = shard(key);
+
+    std::lock_guard<std::mutex> lock(s.mtx);
+
+    auto it = s.map.find(key);
+    if (it != s.map.end())
+    {
+        it->second->decision = d;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return;
+    }
+
+    // The least recently used entry makes room, its list node being reused.
+    if (s.map.size() >= per_shard)
+    {
+        s.map.erase(s.lru.back().key);
+        s.lru.splice(s.lru.begin(), s.lru, std::prev(s.lru.end()));
+        s.lru.front() = { key, d };
+    }
+    else
+        s.lru.push_front({ key, d });
+
+    s.map.emplace(key, s.lru.begin());
+}
+
+void DecisionCache::clear()
+{
+    for (auto& s : shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        s.lru.clear();
+        s.map.clear();
+    }
+}
+
+size_t DecisionCache::size() const
+{
+    size_t n = 0;
+    for (auto& s : shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        n += s.map.size();
+    }
+    return n;
+}
+
+}  // namespace mcts
@@ -0,0 +1,183 @@
+
+#include <assert.h>
+#include "connectfour.h"
+
+namespace mcts {
+
+//******************************  Util functions  **********************/
+
+/**
+ * Moves are the columns, indexed starting at 1 since MOVE(0) is MOVE_NONE.
+ */
+int ConnectFour::moveToColumn(Move m)
+{
+    return m - 1;
+}
+
+Move ConnectFour::columnToMove(int col)
+{
+    return Move(1 + col);
+}
+
+//*********************************  State  ******************************/
+
+ConnectFour::ConnectFour()
+    : gamePly(1)
+{
+    for (int c=0; c<WIDTH; ++c)
+    {
+        m_height[c] = c * H1;
+    }
+    m_valid_actions.reserve(WIDTH);
+
+    m_start.key = 0;
+    m_start.gamePly = 1;
+    m_start.previous = nullptr;
+    data = &m_start;
+}
+
+ConnectFour::ConnectFour(const ConnectFour& other)
+    : data(&m_start)
+    , gamePly(other.gamePly)
+    , m_board(other.m_board)
+    , m_height(other.m_height)
+{
+    m_valid_actions.reserve(WIDTH);
+
+    start_from(m_start, *other.data);
+}
+
+ConnectFour& ConnectFour::operator=(const ConnectFour& other)
+{
+    if (this != &other)
+    {
+        gamePly  = other.gamePly;
+        m_board  = other.m_board;
+        m_height = other.m_height;
+        data = start_from(m_start, *other.data);
+    }
+    return *this;
+}
+
+Key ConnectFour::key() const
+{
+    return data->key;
+}
+
+Key ConnectFour::key_after(Move m) const
+{
+    int square  = m_height[moveToColumn(m)];
+    Token token = next_player();
+
+    bool win  = is_win(m_board[token - 1] | bitboard_t(1) << square);
+    bool full = gamePly >= MAX_GAME_PLY;
+
+    Key key = data->key ^ Zobrist::stoneKey(square, token) ^ Zobrist::sideKey;
+    key ^= status_bits(win, full);
+
+    return key;
+}
+
+Token ConnectFour::next_player() const
+{
+    return gamePly & 1 ? X : O;
+}
+
+bool ConnectFour::is_full() const
+{
+    return gamePly > MAX_GAME_PLY;
+}
+
+bool ConnectFour::is_valid(Move move) const
+{
+    int col = moveToColumn(move);
+    return col >= 0 && col < WIDTH && m_height[col] < col * H1 + HEIGHT;
+}
+
+// The central columns first, they are the better moves more often than not.
+std::vector<Move>& ConnectFour::valid_actions()
+{
+    static constexpr std::array<int, WIDTH> ORDER = { 3, 2, 4, 1, 5, 0, 6 };
+
+    m_valid_actions.clear();
+
+    if (is_terminal())
+    {
+        return m_valid_actions;
+    }
+
+    for (int c : ORDER)
+    {
+        if (m_height[c] < c * H1 + HEIGHT)
+            m_valid_actions.push_back(columnToMove(c));
+    }
+    return m_valid_actions;
+}
+
+Token ConnectFour::winner() const
+{
+    if (is_win(m_board[X - 1])) { return X; }
+    if (is_win(m_board[O - 1])) { return O; }
+    return TOK_EMPTY;
+}
+
+// The status is kept in the key, see key_terminal().
+bool ConnectFour::is_terminal() const
+{
+    return key_terminal(data->key);
+}
+
+bool ConnectFour::is_draw() const
+{
+    return is_full() && winner() == TOK_EMPTY;
+}
+
+void ConnectFour::apply_move(Move m, StateData& new_sd)
+{
+    Key key = data->key;
+    new_sd.gamePly = gamePly + 1;
+    new_sd.previous = data;
+    data = &(new_sd);
+
+    // Drop the stone on top of the column.
+    assert(is_valid(m));
+    Token token = next_player();
+    int square  = m_height[moveToColumn(m)]++;
+    m_board[token - 1] |= bitboard_t(1) << square;
+    ++gamePly;
+
+    key ^= Zobrist::stoneKey(square, token);
+
+    // Only the player who just moved can have won.
+    bool win = is_win(m_board[token - 1]);
+    key ^= Zobrist::sideKey;
+    key ^= status_bits(win, is_full());
+
+    data->key = key;
+}
+
+void ConnectFour::undo_move(Move m)
+{
+    // The last stone of the column is the one to remove.
+    int square = --m_height[moveToColumn(m)];
+    --gamePly;
+    m_board[next_player() - 1] &= ~(bitboard_t(1) << square);
+    assert(square >= moveToColumn(m) * H1);
+
+    data = data->previous;
+}
+
+ConnectFour::bitboard_t ConnectFour::board(Token token) const
+{
+    return m_board[token - 1];
+}
+
+Token ConnectFour::at(int col, int row) const
+{
+    bitboard_t bit = bitboard_t(1) << (col * H1 + row);
+    return m_board[X - 1] & bit ? X
+         : m_board[O - 1] & bit ? O
+                                : TOK_EMPTY;
+}
+
+} // namespace mcts
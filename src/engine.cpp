@@ -0,0 +1,307 @@
+#include <cstdlib>
+#include <limits>
+#include "engine.h"
+
+namespace mcts {
+
+Engine::~Engine()
+{
+    finish();
+
+    if (Agent::shared_table == &shared)
+        Agent::shared_table = nullptr;
+    if (Agent::decision_cache && Agent::decision_cache == cache.get())
+        Agent::decision_cache = nullptr;
+}
+
+void Engine::loop(std::istream& in)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream is(line);
+        std::string cmd;
+        if (!(is >> cmd))
+            continue;
+
+        if (cmd == "quit")            break;
+        else if (cmd == "isready")    send("readyok");
+        else if (cmd == "position")   position(is);
+        else if (cmd == "go")         go(is);
+        else if (cmd == "ponder")     ponder();
+        else if (cmd == "stop")       stop();
+        else if (cmd == "setoption")  setoption(is);
+        else if (cmd == "stats")      stats();
+        else                          send("info string unknown command " + cmd);
+    }
+
+    finish();
+}
+
+void Engine::position(std::istringstream& is)
+{
+    finish();
+
+    state = State();
+
+    std::string token;
+    is >> token;    // startpos, the only one there is.
+
+    int i = 0;
+    while (is >> token)
+    {
+        if (token == "moves")
+            continue;
+
+        int cell = std::atoi(token.c_str());
+        Move move = cell >= 1 && cell <= 9 ? State::cellTokenToMove(Cell(cell - 1), state.next_player())
+                                           : MOVE_NONE;
+
+        if (move == MOVE_NONE || state.is_terminal() || !state.is_valid(move))
+        {
+            send("info string illegal move " + token);
+            break;
+        }
+        state.apply_move(move, sd[i++]);
+    }
+
+    // Between the moves, so that the next search's clock isn't spent on it.
+    if (Agent::compact_tree)
+        agent.compact();
+}
+
+void Engine::go(std::istringstream& is)
+{
+    finish();
+
+    if (state.is_terminal())
+    {
+        send("bestmove none");
+        return;
+    }
+
+    save_budget();
+
+    std::string token;
+    while (is >> token)
+    {
+        if (token == "movetime")
+        {
+            int ms = 0;
+            is >> ms;
+            Agent::set_search_time(ms);
+            Agent::use_time = true;
+            Agent::MAX_ITER = std::numeric_limits<int>::max();
+        }
+        else if (token == "iterations")
+        {
+            is >> Agent::MAX_ITER;
+            Agent::use_time = false;
+        }
+        else if (token == "infinite")
+        {
+            Agent::MAX_ITER = std::numeric_limits<int>::max();
+            Agent::use_time = false;
+            infinite = true;
+        }
+    }
+
+    pondering = false;
+    reported = false;
+    handle.start([this](Move move) {
+        expect_reply(move);
+        send_bestmove(move);
+    });
+}
+
+// Thinks on the opponent's time, as UCI's go ponder: once the engine's move is
+// played, the position searched is the one after the reply its search expects,
+// the one it will most likely be asked to play in next. Without an expected
+// reply, the current position is searched, which grows the trees of the replies.
+void Engine::ponder()
+{
+    finish();
+
+    if (state.is_terminal())
+        return;
+
+    if (state.key() == ponder_key && state.is_valid(ponder_reply))
+    {
+        state.apply_move(ponder_reply, ponder_sd);
+        pondered = ponder_reply;
+
+        if (state.is_terminal())
+        {
+            unponder();
+            return;
+        }
+    }
+
+    save_budget();
+    Agent::MAX_ITER = std::numeric_limits<int>::max();
+    Agent::use_time = false;
+
+    pondering = true;
+    infinite = true;
+    reported = false;
+    handle.start([this](Move move) { if (!pondering) send_bestmove(move); });
+}
+
+// From the search thread, once the search is over: the reply expected to the
+// move is the next one of the principal variation.
+void Engine::expect_reply(Move move)
+{
+    SearchInfo si = agent.info();
+    bool known = si.pv.size() >= 2 && si.pv[0] == move;
+
+    ponder_key   = known ? state.key_after(move) : 0;
+    ponder_reply = known ? si.pv[1] : MOVE_NONE;
+}
+
+void Engine::unponder()
+{
+    if (pondered == MOVE_NONE)
+        return;
+
+    state.undo_move(pondered);
+    pondered = MOVE_NONE;
+}
+
+// The move is the one published by the last iteration, the search thread is
+// joined later, by the next command that needs the agent. The ponder search
+// isn't answered, its position isn't one the engine was asked to play in.
+void Engine::stop()
+{
+    if (pondering)
+    {
+        reported = true;
+        handle.stop();
+        return;
+    }
+    send_bestmove(handle.stop());
+}
+
+void Engine::setoption(std::istringstream& is)
+{
+    finish();
+
+    std::string token, name, value;
+    is >> token >> name >> token;    // name NAME value
+    std::getline(is, value);
+
+    if (name == "profile")
+    {
+        std::istringstream vs(value);
+        vs >> value;
+        if (!Agent::load_profile(value))
+            send("info string could not read profile " + value);
+    }
+    else if (name == "shared")
+    {
+        std::istringstream vs(value);
+        vs >> value;
+        Agent::shared_table = shared.open(value) ? &shared : nullptr;
+        if (!Agent::shared_table)
+            send("info string could not open shared table " + value);
+    }
+    else if (name == "cache")
+    {
+        size_t n = std::strtoull(value.c_str(), nullptr, 10);
+        cache = n ? std::make_unique<DecisionCache>(n) : nullptr;
+        Agent::decision_cache = cache.get();
+    }
+    else if (name == "info_period")
+        info_period = std::max(1, std::atoi(value.c_str()));
+    else if (!Agent::set_option(name, value))
+        send("info string unknown option " + name);
+
+    handle.subscribe([this](const SearchInfo& si) { send_info(si); }, info_period);
+}
+
+void Engine::stats()
+{
+    if (handle.running())
+    {
+        send("info string searching, best so far " + std::to_string(to_cell(agent.best_so_far())));
+        return;
+    }
+
+    SearchInfo si = agent.info();
+    std::ostringstream os;
+    os << "info string nodes " << MCTS.size()
+       << " bytes " << Agent::table_bytes()
+       << " evicted " << agent.evictions()
+       << " iterations " << si.iterations;
+    if (cache)
+        os << " cache " << cache->size() << " hits " << cache->hits() << " misses " << cache->misses();
+    send(os.str());
+}
+
+// Waits for the current search, if any, takes back the pondered reply and restores
+// the budget. The searches without a budget are stopped, and their bestmove isn't sent.
+void Engine::finish()
+{
+    if (infinite)
+    {
+        reported = true;
+        handle.stop();
+    }
+    handle.wait();
+    unponder();
+    pondering = false;
+    infinite = false;
+
+    if (budget_saved)
+    {
+        Agent::MAX_ITER = saved_iter;
+        Agent::MAX_TIME = saved_time;
+        Agent::use_time = saved_use_time;
+        budget_saved = false;
+    }
+}
+
+// Before a search overwrites the budget, for finish() to restore it.
+void Engine::save_budget()
+{
+    saved_iter = Agent::MAX_ITER;
+    saved_time = Agent::MAX_TIME;
+    saved_use_time = Agent::use_time;
+    budget_saved = true;
+}
+
+void Engine::send(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(out_mtx);
+    out << line << std::endl;
+}
+
+void Engine::send_info(const SearchInfo& si)
+{
+    std::ostringstream os;
+    os << "info iterations " << si.iterations << " time " << si.elapsed_ms;
+
+    if (si.best_move != MOVE_NONE)
+        os << " best " << to_cell(si.best_move);
+
+    os << " pv";
+    for (Move m : si.pv)
+        os << ' ' << to_cell(m);
+
+    os << " visits";
+    for (const auto& [m, n] : si.root_visits)
+        os << ' ' << to_cell(m) << ':' << n;
+
+    send(os.str());
+}
+
+// Sends the bestmove of the current search only once, whoever of the search
+// thread and the stop command comes first.
+void Engine::send_bestmove(Move move)
+{
+    if (reported.exchange(true))
+        return;
+
+    send(move == MOVE_NONE ? "bestmove none" : "bestmove " + std::to_string(to_cell(move)));
+}
+
+} // namespace mcts
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include "evaluator.h"
+#include "solver.h"
+
+namespace mcts {
+
+namespace {
+
+    constexpr std::array<std::array<int, 3>, 8> LINES = { { { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 },
+        { 0, 3, 6 }, { 1, 4, 7 }, { 2, 5, 8 }, { 0, 4, 8 }, { 2, 4, 6 } } };
+
+    Token opponent(Token t) { return t == X ? O : X; }
+
+    // Number of tokens of `t` on the line if the opponent has none there, -1 otherwise.
+    int open_count(const State::grid_t& grid, const std::array<int, 3>& line, Token t)
+    {
+        int n = 0;
+        for (int c : line)
+        {
+            if (grid[c] == opponent(t))
+                return -1;
+            n += grid[c] == t;
+        }
+        return n;
+    }
+
+    void normalize(Evaluation& e, int n_moves)
+    {
+        double sum = 0;
+        for (int i = 0; i < n_moves; ++i)
+            sum += e.priors[i];
+        for (int i = 0; i < n_moves; ++i)
+            e.priors[i] = sum > 0 ? e.priors[i] / sum : 1.0 / n_moves;
+    }
+
+} // namespace
+
+//***************************** Heuristic evaluator ***********************/
+
+void HeuristicEvaluator::evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out)
+{
+    out.resize(leaves.size());
+
+    for (size_t l = 0; l < leaves.size(); ++l)
+    {
+        const Leaf& leaf = leaves[l];
+        Evaluation& e    = out[l];
+        Token us = leaf.to_move, them = opponent(us);
+
+        std::array<int, 3> ours {}, theirs {};    // Open lines by number of tokens.
+        for (const auto& line : LINES)
+        {
+            int n = open_count(leaf.grid, line, us);
+            if (n >= 0) ++ours[std::min(n, 2)];
+            n = open_count(leaf.grid, line, them);
+            if (n >= 0) ++theirs[std::min(n, 2)];
+        }
+
+        if (ours[2] > 0)
+            e.value = 0.95;                       // We win on this move.
+        else if (theirs[2] > 1)
+            e.value = 0.1;                        // Two threats can't both be blocked.
+        else
+            e.value = std::clamp(0.5 + 0.08 * (ours[1] - theirs[1]) - 0.1 * theirs[2], 0.05, 0.95);
+
+        for (int i = 0; i < leaf.n_moves; ++i)
+        {
+            int cell = State::moveToCell(leaf.moves[i]);
+            double w = cell == 4 ? 2.0 : cell % 2 == 0 ? 1.5 : 1.0;
+
+            for (const auto& line : LINES)
+            {
+                if (std::find(line.begin(), line.end(), cell) == line.end())
+                    continue;
+                if (open_count(leaf.grid, line, us) == 2)   w += 8;    // Completes a line.
+                if (open_count(leaf.grid, line, them) == 2) w += 4;    // Blocks one.
+            }
+            e.priors[i] = w;
+        }
+        normalize(e, leaf.n_moves);
+    }
+}
+
+//******************************* Table evaluator *************************/
+
+void TableEvaluator::evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out)
+{
+    out.resize(leaves.size());
+
+    for (size_t l = 0; l < leaves.size(); ++l)
+    {
+        const Leaf& leaf = leaves[l];
+        Evaluation& e    = out[l];
+        int ndx          = State::index(leaf.grid);
+        Solver::Value v  = table.value(ndx);
+
+        e.value = Solver::to_reward(v);
+
+        for (int i = 0; i < leaf.n_moves; ++i)
+        {
+            Move m    = leaf.moves[i];
+            int child = ndx + State::moveToToken(m) * State::POW3[State::moveToCell(m)];
+            e.priors[i] = Solver::flip(table.value(child)) == v ? 1.0 : 0.05;
+        }
+        normalize(e, leaf.n_moves);
+    }
+}
+
+//******************************* Async evaluator *************************/
+
+AsyncEvaluator::AsyncEvaluator(Evaluator& evaluator)
+    : evaluator(evaluator)
+    , worker(&AsyncEvaluator::loop, this)
+{
+}
+
+AsyncEvaluator::~AsyncEvaluator()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+std::future<std::vector<Evaluation>> AsyncEvaluator::submit(std::vector<Leaf> batch)
+{
+    std::future<std::vector<Evaluation>> result;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        requests.push_back(Request{ std::move(batch), {} });
+        result = requests.back().result.get_future();
+    }
+    cv.notify_one();
+
+    return result;
+}
+
+// The pending requests are still served when quitting, so no future is left broken.
+void AsyncEvaluator::loop()
+{
+    while (true)
+    {
+        Request req;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return quit || !requests.empty(); });
+
+            if (requests.empty())
+                return;
+
+            req = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        std::vector<Evaluation> out;
+        evaluator.evaluate(req.leaves, out);
+        req.result.set_value(std::move(out));
+    }
+}
+
+} // namespace mcts
@@ -1,50 +1,132 @@
 #include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <deque>
 #include <cassert>
+#include <cstring>
 #include <math.h>
+#include <queue>
 #include <random>
+#include <unordered_set>
+#include <tuple>
+#include <utility>
 #include "mcts.h"
+#include "alloc.h"
+#include "connectfour.h"
+#include "mnk.h"
+#include "snapshot.h"
+#include "cache.h"
+#include "evaluator.h"
+#include "shared.h"
+#include "solver.h"
+#include "trace.h"
 #include "debug.h"
 
 
 namespace mcts {
 
-MCTSLookupTable MCTS;
-
 //****************************** Utility functions ***********************/
 
 // get_node queries the Hash Table until it finds the position,
-// creating a new entry in case it doesn't find it.
-Node* get_node(const State& state)
+// creating a new entry in case it doesn't find it. New entries start
+// from the warm start snapshot when it has a record of the position.
+template<Game G>
+BasicNode<G>* get_node(const G& state)
 {
-    Key state_key = state.key();
+    auto state_key = state.key();
+
+    // In the direct table, the index is exact: a slot is either unused (never
+    // reached by any search) or it holds the position.
+    if constexpr (Indexable<G>)
+    {
+        if (uses_direct_nodes<G>())
+        {
+            auto& node = direct_nodes<G>[state.index()];
+            assert(node.generation == 0 || node.key == state_key);
+
+            if (node.generation == 0)
+            {
+                node = BasicNode<G>();
+                node.key = state_key;
+                if constexpr (std::is_same_v<G, State>)
+                {
+                    if (AgentBase::warm_start)
+                    {
+                        if (const auto* rec = AgentBase::warm_start->find(state_key))
+                            Snapshot::to_node(*rec, node);
+                    }
+                }
+            }
+            node.generation = AgentBase::generation;
+            return &node;
+        }
+    }
 
-    auto node_it = MCTS.find(state_key);
-    if (node_it != MCTS.end())
+    auto& table = game_table<G>;
+
+    auto node_it = table.find(state_key);
+    if (node_it != table.end())
     {
+        node_it->second.generation = AgentBase::generation;
         return &(node_it->second);
     }
 
+    if (auto* node = game_arena<G>.find(state_key))
+    {
+        node->generation = AgentBase::generation;
+        return node;
+    }
+
     // Insert the new node in the Hash table if it wasn't found.
-    Node new_node;
+    BasicNode<G> new_node;
     new_node.key                    = state_key;
+    new_node.generation             = AgentBase::generation;
     //new_node.last_move              = actions[ply]->move;
 
-    auto new_node_it = MCTS.insert(std::make_pair(state_key, new_node)).first;
+    if constexpr (std::is_same_v<G, State>)
+    {
+        if (AgentBase::warm_start)
+        {
+            if (const auto* rec = AgentBase::warm_start->find(state_key))
+                Snapshot::to_node(*rec, new_node);
+        }
+    }
+
+    auto new_node_it = table.insert(std::make_pair(state_key, new_node)).first;
     return &(new_node_it->second);
 }
 
+// The node of a position in the keyed table or the arena, nullptr if it has none.
+template<Game G>
+BasicNode<G>* find_node(typename G::key_type key)
+{
+    auto it = game_table<G>.find(key);
+    return it != game_table<G>.end() ? &(it->second) : game_arena<G>.find(key);
+}
+
+// The games without a Debug::display() are shown by their key.
+template<Game G>
+void display(std::ostream& os, const G& state)
+{
+    if constexpr (requires { Debug::display(os, state); })
+        Debug::display(os, state);
+    else
+        os << "Position " << state.key() << " at ply " << state.gamePly << '\n';
+}
+
 // Used for choosing moves during the random_simulations.
 namespace Random {
 
     std::random_device rd;
     std::mt19937 e{rd()}; // or std::default_random_engine e{rd()};
-    std::uniform_int_distribution<int> dist{0, Agent::MAX_CHILDREN};
 
-    Move choose(std::vector<Move>& choices)
+    template<class Moves>
+    Move choose(const Moves& choices)
     {
         if (choices.empty())
             return MOVE_NONE;
-        return choices[dist(rd) % choices.size()];
+        return choices[std::uniform_int_distribution<size_t>{0, choices.size() - 1}(e)];
     }
 }
 
@@ -66,7 +148,8 @@ TimePoint time_elapsed()
 
 //******************************** Ctor(s) *******************************/
 
-Agent::Agent(State& state)
+template<Game G, class Selection, class Final>
+BasicAgent<G, Selection, Final>::BasicAgent(G& state)
     : state(state)
     , nodes{}
     , stackBuf{}
@@ -74,19 +157,78 @@ Agent::Agent(State& state)
     create_root();
 }
 
+// Joins the evaluator's thread, AsyncEvaluator being complete here.
+template<Game G, class Selection, class Final>
+BasicAgent<G, Selection, Final>::~BasicAgent() = default;
+
 //******************************** Main methods ***************************/
 
-Move Agent::MCTSBestMove()
+template<Game G, class Selection, class Final>
+Move BasicAgent<G, Selection, Final>::MCTSBestMove()
 {
+    if constexpr (is_tictactoe)
+    {
+        // Nothing is searched either: the counters are zero, and info() reports the table's move.
+        if (perfect_moves && perfect_table)
+        {
+            init_time();
+            reset_counters();
+
+            Move move = perfect_table->best_move(state);
+            cached_info.emplace();
+            cached_info->best_move = move;
+            if (move != MOVE_NONE)
+                cached_info->pv = { move };
+
+            best_move.store(move, std::memory_order_relaxed);
+            return move;
+        }
+
+        // Nothing is searched: the counters are zero, and info() is the cached search's.
+        if (decision_cache)
+        {
+            if (auto hit = decision_cache->find(state, DecisionCache::budget(), DecisionCache::config<Selection, Final>()))
+            {
+                init_time();
+                reset_counters();
+
+                cached_info.emplace();
+                cached_info->best_move  = hit->move;
+                cached_info->iterations = hit->iterations;
+                cached_info->pv         = { hit->move };
+                cached_info->root_visits.assign(hit->visits.begin(), hit->visits.begin() + hit->n_children);
+
+                best_move.store(hit->move, std::memory_order_relaxed);
+                return hit->move;
+            }
+        }
+    }
+
     init_time();
+    auto allocs = Alloc::stats();
     create_root();
 
-    while (computation_resources())
+    tracer = trace_search ? &Trace::ring() : nullptr;
+    if (tracer)
+        tracer->record(Trace::EVENT_SEARCH, 0, 0, MOVE_NONE, 0, root->n_visits);
+
+    ActionNode* halving_choice = nullptr;
+    bool batched = false;
+
+    if constexpr (is_tictactoe)
     {
-        Node* node = tree_policy();
-        Reward reward = rollout_policy(node);
-        backpropagate(node, reward);
-        ++iteration_cnt;
+        if ((batched = evaluator != nullptr))
+            search_batched();
+    }
+
+    // The halving spends the whole budget itself.
+    if (!batched && root_halving && !use_time && root->n_children > 1 && !root->best_known)
+        halving_choice = sequential_halving();
+    else
+    {
+        // Stop as soon as the root is solved.
+        while (computation_resources() && !root->best_known)
+            iterate();
     }
 
     if (debug_counters)
@@ -95,10 +237,41 @@ Move Agent::MCTSBestMove()
         std::cerr << "Descent count: " << descent_cnt << '\n';
         std::cerr << "Rollout count: " << rollout_cnt << '\n';
         std::cerr << "Exploration count: " << explored_nodes_cnt << '\n';
-        std::cerr << "Number of nodes in table: " << MCTS.size() << std::endl;
+        std::cerr << "Solved count: " << solved_nodes_cnt << '\n';
+        std::cerr << "Number of nodes in table: " << game_table<G>.size() << '\n';
+        std::cerr << "Bytes used by table: " << table_bytes() << '\n';
+        std::cerr << "Evicted nodes: " << evicted_cnt << '\n';
+        if (Alloc::counting())
+            std::cerr << "Allocations: " << Alloc::stats() - allocs << std::endl;
     }
 
-    auto* choice = best_visits(root);
+    // When the root is solved its children are sorted by exact value.
+    auto* choice = root->best_known ? &root->children[0]
+                 : halving_choice   ? halving_choice
+                                    : best_final(root);
+
+    best_move.store(choice->move, std::memory_order_relaxed);
+
+    if (tracer)
+        tracer->record(Trace::EVENT_RESULT, iteration_cnt, 0, choice->move);
+
+    // The searches stopped before their budget would answer the next ones short.
+    if constexpr (is_tictactoe)
+    {
+        if (decision_cache && !stop_requested.load(std::memory_order_relaxed))
+        {
+            DecisionCache::Decision d;
+            d.move        = choice->move;
+            d.iterations  = iteration_cnt;
+            d.root_visits = root->n_visits;
+            d.value       = choice->avg_action_value;
+            d.n_children  = root->n_children;
+            for (int i=0; i<root->n_children; ++i)
+                d.visits[i] = { root->children[i].move, root->children[i].n_visits };
+
+            decision_cache->insert(state, DecisionCache::budget(), d, DecisionCache::config<Selection, Final>());
+        }
+    }
 
     if (debug_main_methods)
         std::cerr << "returning from main method" << std::endl;
@@ -106,48 +279,111 @@ Move Agent::MCTSBestMove()
     return choice->move;
 }
 
-void Agent::create_root()
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::create_root()
 {
     ply                 = state.data->gamePly;
+    root_ply            = ply;
     states[ply].gamePly = ply;
     states[ply].key     = state.key();
 
     // Reset the buffers
     nodes = {};
 
-    // Reset the counters
-    iteration_cnt       = 0;
-    rollout_cnt         = 0;
-    descent_cnt         = 0;
-    explored_nodes_cnt  = 0;
+    reset_counters();
+    cached_info.reset();
+    halving_leader = MOVE_NONE;
+
+    ++generation;
 
+    if (max_bytes && !uses_direct_table())
+        reserve_budget();
+
+    if constexpr (is_indexable)
+    {
+        if (uses_direct_table() && direct_nodes<G>.size() < G::INDEX_SIZE)
+            direct_nodes<G>.resize(G::INDEX_SIZE);
+    }
+
+    make_room();
     root = nodes[ply] = get_node(state);
 
-    if (root->n_visits == 0)
+    // With an evaluator, a new root is expanded by the first batch, as a leaf,
+    // so that its children get the evaluator's priors.
+    bool batched = false;
+    if constexpr (is_tictactoe)
+        batched = evaluator != nullptr;
+
+    if (root->n_visits == 0 && !batched)
     {
         init_children();
     }
 
-    // TODO Clear the part of the tree that's dismissed in the cache
+    if (root->n_children > 0)
+        best_move.store(root->children[0].move, std::memory_order_relaxed);
+    else
+        reset_best_move();
+    next_update = update_period;
+
+    // NOTE: The part of the tree that's dismissed isn't cleared here, but its nodes
+    // are from older generations so they are the first ones to go in evict().
+}
+
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::reset_counters()
+{
+    iteration_cnt       = 0;
+    rollout_cnt         = 0;
+    descent_cnt         = 0;
+    explored_nodes_cnt  = 0;
+    solved_nodes_cnt    = 0;
+    evicted_cnt         = 0;
 }
 
-bool Agent::computation_resources()
+template<Game G, class Selection, class Final>
+bool BasicAgent<G, Selection, Final>::computation_resources()
 {
-    bool res =  iteration_cnt < MAX_ITER;
+    bool res =  iteration_cnt < MAX_ITER && !stop_requested.load(std::memory_order_relaxed);
 
     if (use_time)
-        res &= (time_elapsed() < MAX_TIME - 100);    // Clock keeps running when using gdb.
+        res &= (time_elapsed() < MAX_TIME - TIME_MARGIN);    // Clock keeps running when using gdb.
 
     return res;
 }
 
-Node* Agent::tree_policy()
+// One iteration: a descent from the root, with the first edge imposed if `first`
+// isn't null, the evaluation of the leaf and the backpropagation.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::iterate(ActionNode* first)
+{
+    if (tracer)
+        tracer->record(Trace::EVENT_ITERATION, iteration_cnt, 0);
+
+    Node* node = tree_policy(first);
+    if (tracer)
+        tracer->record(Trace::EVENT_LEAF, iteration_cnt, ply - root_ply);
+
+    Reward reward = rollout_policy(node);
+    if (tracer)
+        tracer->record(Trace::EVENT_ROLLOUT, iteration_cnt, ply - root_ply, MOVE_NONE, 0, reward);
+
+    backpropagate(node, reward, rollout_weight);
+    if (tracer)
+        tracer->record(Trace::EVENT_BACKUP, iteration_cnt, 0);
+
+    ++iteration_cnt;
+    publish();
+}
+
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::tree_policy(ActionNode* first) -> Node*
 {
     assert(current_node() == root);
+    Alloc::Scope phase(Alloc::PHASE_SELECTION);
 
     if (debug_tree)
     {
-        Debug::display(std::cerr, state);
+        display(std::cerr, state);
         std::cerr << "Initializing descent " << descent_cnt << std::endl;
     }
 
@@ -165,39 +401,69 @@ Node* Agent::tree_policy()
     // or short term)
     while (current_node()->n_visits > 0)
     {
-        if (is_terminal(current_node()))
+        // Values below a solved node are exact, there is nothing left to sample.
+        if (is_terminal(current_node()) || current_node()->best_known)
         {
             if (debug_tree)
-                std::cerr << "Terminal node hit." << std::endl;
+                std::cerr << "Terminal or solved node hit." << std::endl;
 
             return current_node();
         }
 
-        // The choice of Edge (action) at each node is driven by the uct policy
-        actions[ply] = best_uct(current_node());
+        // The other processes' visits count as ours.
+        if constexpr (is_tictactoe)
+        {
+            if (shared_table)
+                shared_table->load(*current_node());
+        }
+
+        // Let the next children in, as the visits grow.
+        if (current_node()->n_expanded_children < current_node()->n_children)
+            widen(current_node());
+
+        // The choice of Edge (action) at each node is driven by the uct policy,
+        // unless the root's action was imposed.
+        actions[ply] = first ? std::exchange(first, nullptr) : best_uct(current_node());
+        ActionNode* action = actions[ply];
 
         // Keep record of number of times each part of the tree has been sampled.
         ++current_node()->n_visits;
 
-        Move move = actions[ply]->move;  // Keep record of the path we're tracing to go back along it.
+        Move move = action->move;        // Keep record of the path we're tracing to go back along it.
         assert(move != MOVE_NONE);       // TODO Remove this
+
+        if (tracer)
+            tracer->record(Trace::EVENT_SELECT, iteration_cnt, ply - root_ply, move, action - current_node()->children.data());
+        Node* next = child_hint(action);
         apply_move(move);
 
-        nodes[ply] = get_node(state);    // Either the node has been seen and is associated to a state key,
-                                         // or not and get_node creates a record of it.
+        if (next)                        // The edge still knows its node, no need to query the table.
+        {
+            assert(next->key == state.key());
+            next->generation = generation;
+            nodes[ply] = next;
+        }
+        else
+        {
+            make_room();
+            nodes[ply] = get_node(state);    // Either the node has been seen and is associated to a state key,
+                                             // or not and get_node creates a record of it.
+            action->child_key   = state.key();
+            action->child       = nodes[ply];
+            action->child_epoch = table_epoch;
+        }
 
         if (debug_tree)
         {
-            Debug::display(std::cerr, state);
+            display(std::cerr, state);
             std::cerr << "Continuing descent..." << std::endl;
         }
 
-        // FIXME How to deal with different paths (different nodes in the tree) leading
-        // to equivalent state position? The state key will be the same but not the nodes.
-        // Have to make sure to only keep the best path and reorganize the tree without losing information.
-        // NOTE in this direction : currently the last_move field of a Node object isn't used! it can have
-        // multiple parents. This most likely messes with the algorithm by favoring positions that arise
-        // more frequenty.
+        // NOTE: Different paths leading to the same position share its node, which can
+        // thus have multiple parents. The edge statistics only count the visits through
+        // their own parent, which is what the exploration term uses, but they favor the
+        // positions that arise more frequently. In graph_search mode, the exploitation term
+        // is instead read from the child node, whose statistics aggregate every path to it.
     }
 
     // At this point, we reached an unexplored node and it is time to explore the game tree from
@@ -205,7 +471,7 @@ Node* Agent::tree_policy()
     if (debug_main_methods)
     {
         std::cerr << "Chosen node \n";
-        Debug::display(std::cerr, state);
+        display(std::cerr, state);
         std::cerr << std::endl;
     }
 
@@ -214,16 +480,19 @@ Node* Agent::tree_policy()
 
 // Once we have the next unexplored node, we do a random
 // playout starting with every one of its children.
-Reward Agent::rollout_policy(Node* node)
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::rollout_policy(Node* node)
 {
     if (debug_main_methods)
     {
         std::cerr << "Rollout on node with state \n";
-        Debug::display(std::cerr, state);
+        display(std::cerr, state);
     }
 
     assert(node == current_node());
 
+    rollout_weight = 1;
+
     // NOTE: this doesn't seem to be necessary, we do
     // the same check when doing the random_simulation. Well, it would be
     // node->children will be { MOVE_END } and we would need to make a check before return
@@ -237,18 +506,60 @@ Reward Agent::rollout_policy(Node* node)
         return 1 - evaluate_terminal();
     }
 
+    if (node->best_known)
+    {
+        ++node->n_visits;
+        return node->children[0].prior_value;
+    }
+
     assert(node->n_visits == 0);
 
     init_children();                      // Expand the node and do a rollout on each child, return max reward.
 
-    return node->children[0].prior_value;
+    if (leaf_playouts == 0 || node->best_known)
+        return node->children[0].prior_value;
+
+    // When playouts are cheap next to the descent and the table lookups, several of them
+    // amortize the selection. Their mean goes up the tree once, weighing as many visits.
+    int k = playouts_at(ply - root_ply);
+    Reward r = 0;
+    Alloc::Scope phase(Alloc::PHASE_SIMULATION);
+
+    rollout_weight = k;
+
+    if constexpr (is_tictactoe)
+    {
+        if (simd_playouts)
+            return batch_playouts(k);
+    }
+
+    for (int i=0; i<k; ++i)
+    {
+        r += random_simulation(Random::choose(state.valid_actions()));
+        ++rollout_cnt;
+    }
+
+    return r / k;
+}
+
+// Playouts at a leaf `depth` plies below the root: the leaves close to the root
+// weigh more in the decision, deeper ones can make do with fewer.
+template<Game G, class Selection, class Final>
+int BasicAgent<G, Selection, Final>::playouts_at(int depth) const
+{
+    return std::max(1, leaf_playouts - playouts_decay * depth);
 }
 
 // Note: as in Stockfish's, we could backpropagate minimax of avg_value instead of rollout reward.
 // (the more confident we are in our sampling, the more we want to propagate extremal results only?)
-void Agent::backpropagate(Node* node, Reward r)
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::backpropagate(Node* node, Reward r, int weight)
 {
     assert(node == current_node());
+    Alloc::Scope phase(Alloc::PHASE_BACKPROPAGATION);
+
+    // The leaf counted a single visit too.
+    node->n_visits += weight - 1;
 
     while (current_node() != root)
     {
@@ -258,11 +569,25 @@ void Agent::backpropagate(Node* node, Reward r)
 
         ActionNode* action = actions[ply];
 
-        ++action->n_visits;
+        action->n_visits += weight;
 
-        action->action_value += r;
+        action->action_value += weight * r;
+        action->sq_action_value += weight * r * r;
         action->avg_action_value = action->action_value / action->n_visits;
 
+        // The node we just left is shared by all the paths reaching its position.
+        nodes[ply+1]->value_sum += weight * r;
+        nodes[ply+1]->n_updates += weight;
+
+        // The descent counted a single visit of the parent.
+        current_node()->n_visits += weight - 1;
+
+        if constexpr (is_tictactoe)
+        {
+            if (shared_table)
+                shared_table->add(current_node()->key, action->move, weight, weight * r, weight * r * r);
+        }
+
         //if (action->decisive)
 
         // This seem to take care of my whole "action decisive". I just need to make extremals rarer.
@@ -273,30 +598,33 @@ void Agent::backpropagate(Node* node, Reward r)
     }
 }
 
-Reward Agent::evaluate_terminal()
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::evaluate_terminal()
 {
-    Reward r = key_ev_terminal(states[ply]);
+    Reward r = G::terminal_value(states[ply]);
     // record that the leading action is "decisive" if terminal state is a win.
     actions[ply-1]->decisive = r == 1;
 
     return r;
 }
 
-ActionNode* Agent::best_uct(Node* node)
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::best_uct(Node* node) -> ActionNode*
 {
+    double c_explore = Selection::uses_priors ? puct_cst : exploration_cst;
+
     if (debug_tree)
     {
         std::cerr << "Choosing best uct\n";
-        Debug::display(std::cerr, state);
+        display(std::cerr, state);
         std::cerr << "Children are :\n";
         for (int i=0; i<node->n_children; ++i)
         {
             auto c = node->children[i];
-            auto val = (double)c.avg_action_value + exploration_cst * sqrt( (double)(2 * log(node->n_visits)) / (double)(c.n_visits+1) );
+            auto val = Selection::score(*node, c, child_value(&c), c_explore, rng);
 
             std::cerr << "Move " << c.move << " visits " << c.n_visits << " prior  " << c.prior_value << " avg_val " << c.avg_action_value << '\n';
-            std::cerr << "    uct term : " << std::fixed << val;
-            std::cerr << "    for uct value : " << std::fixed << c.avg_action_value + val << "\n\n";
+            std::cerr << "    for uct value : " << std::fixed << val << "\n\n";
         }
 
         std::cerr << "Press c" << std::endl;
@@ -304,22 +632,35 @@ ActionNode* Agent::best_uct(Node* node)
     auto best = 0;
     auto best_val = -std::numeric_limits<double>::max();
 
-    for (int i=0; i<node->n_children; ++i)
+    // In graph_search mode the scores read the children's nodes: they are all
+    // requested before the first one is scored.
+    if (graph_search)
+    {
+        for (int i=0; i<node->n_expanded_children; ++i)
+            prefetch_child(&node->children[i]);
+    }
+
+    for (int i=0; i<node->n_expanded_children; ++i)
     {
         auto* c = &(node->children[i]);
 
-        if (c->n_visits < 1)
+        if (Selection::visit_all_first && c->n_visits < 1)
         {
             if (debug_tree)
                 std::cerr << "\nChoosing " << c->move << std::endl;
-            return c;    // children are already ordered by à priori value in this case.n
+            return c;    // children are already ordered by à priori value in this case.
         }
 
-        Reward r = (double)c->avg_action_value + exploration_cst * sqrt( (double)(2 * log(node->n_visits)) / (double)(c->n_visits+1) );
+        Reward q = c->n_visits > 0 ? child_value(c) : 0.5;
+        Reward r = Selection::score(*node, *c, q, c_explore, rng);
         if (r > best_val)
         {
             best_val = r;
             best = i;
+
+            // The leader's node loads while the other children are scored.
+            if (!graph_search)
+                prefetch_child(c);
         }
     }
 
@@ -329,7 +670,62 @@ ActionNode* Agent::best_uct(Node* node)
     return &(node->children[best]);
 }
 
-ActionNode* Agent::best_visits(Node* node)
+// The mean value of an action: in graph_search mode, it is the mean over all the
+// paths through the resulting position, as long as that position has been updated.
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::child_value(const ActionNode* action)
+{
+    if (graph_search && action->child_key)
+    {
+        const Node* child = child_hint(action);
+        if constexpr (is_indexable)
+        {
+            // The state is at the action's node.
+            if (!child && uses_direct_table())
+            {
+                child = &direct_nodes<G>[state.index_after(action->move)];
+                child = child->generation ? child : nullptr;
+            }
+        }
+        if (!child && !uses_direct_table())
+            child = find_node<G>(action->child_key);
+        if (child && child->n_updates > 0)
+            return child->value_sum / child->n_updates;
+    }
+    return action->avg_action_value;
+}
+
+// The node of the action, from its hint, or else its slot in the direct table: both
+// addresses are known without loading anything, and best_uct() requests them while
+// it scores the children. An edge without either is left to the table's lookup:
+// std::unordered_map gives no address of its buckets, and reaching the node through
+// one takes the very loads the prefetch would hide. The state is at the action's node.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::prefetch_child(const ActionNode* action)
+{
+    if (Node* child = child_hint(action))
+    {
+        __builtin_prefetch(child);
+        return;
+    }
+
+    if constexpr (is_indexable)
+    {
+        if (uses_direct_table())
+            __builtin_prefetch(&direct_nodes<G>[state.index_after(action->move)]);
+    }
+}
+
+// The node an action leads to, if it is known and wasn't evicted since.
+// (Prefetching a stale hint is harmless, but it is never dereferenced.)
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::child_hint(const ActionNode* action) -> Node*
+{
+    return action->child && action->child_epoch == table_epoch ? action->child : nullptr;
+}
+
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::best_visits(Node* node) -> ActionNode*
 {
     if (debug_best_visits)
         std::cerr << "Choosing best visits. choices are :";
@@ -361,7 +757,8 @@ ActionNode* Agent::best_visits(Node* node)
     return &(node->children[best]);
 }
 
-ActionNode* Agent::best_avg_val(Node* node)
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::best_avg_val(Node* node) -> ActionNode*
 {
     // if (debug_best_visits)
     //     std::cerr << "Choosing best visits. choices are :";
@@ -393,106 +790,965 @@ ActionNode* Agent::best_avg_val(Node* node)
     return &(node->children[best]);
 }
 
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::best_final(Node* node) -> ActionNode*
+{
+    int best = 0;
+    auto best_val = -std::numeric_limits<double>::max();
+
+    for (int i=0; i<node->n_children; ++i)
+    {
+        auto v = Final::score(node->children[i]);
+
+        if (debug_best_visits)
+            std::cerr << "Move " << node->children[i].move << " with " << node->children[i].n_visits
+                      << " visits and score " << v << std::endl;
+
+        if (v > best_val)
+        {
+            best_val = v;
+            best = i;
+        }
+    }
+
+    return &(node->children[best]);
+}
+
+//**************************** Sequential halving ***************************/
+
+// With a few hundred iterations at most, what matters is the move finally played
+// (simple regret) rather than the rewards collected along the way (cumulative
+// regret, which UCB minimizes). Sequential halving splits the budget evenly between
+// the rounds and the root's children, keeps the better half of them by mean value
+// after each round and starts over until one is left. The last round gets whatever
+// the rounding left over, so the whole budget is spent here. The descents below the
+// root are UCT.
+//
+// The leader of the last complete round is the move published for stop() and info():
+// a search stopped in the middle of a round answers it, not the most visited child,
+// which is only the one which happened to come first in the round.
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::sequential_halving() -> ActionNode*
+{
+    // Sorted in place, ties broken by the children's order: no allocation.
+    std::array<ActionNode*, MAX_CHILDREN> candidates;
+    int n = root->n_children;
+    for (int i=0; i<n; ++i)
+        candidates[i] = &root->children[i];
+
+    // Children are sorted by prior value, unless an evaluator gave them a policy.
+    std::sort(candidates.begin(), candidates.begin() + n, [](const auto* a, const auto* b){
+            return a->policy != b->policy ? a->policy > b->policy : a < b;
+        });
+    if (halving_top_k > 0 && n > halving_top_k)
+        n = halving_top_k;
+
+    auto by_value = [this](const auto* a, const auto* b){
+        Reward va = child_value(a), vb = child_value(b);
+        return va != vb ? va > vb : a < b;
+    };
+
+    int rounds = 0;
+    while ((1 << rounds) < n)
+        ++rounds;
+
+    halving_leader = candidates[0]->move;
+    best_move.store(halving_leader, std::memory_order_relaxed);
+
+    for (; n > 1; --rounds)
+    {
+        if (rounds == 1)
+        {
+            for (int i=0; computation_resources() && !root->best_known; i = (i + 1) % n)
+                iterate(candidates[i]);
+        }
+        else
+        {
+            int per_child = std::max(1, (MAX_ITER - iteration_cnt) / (rounds * n));
+
+            for (int c=0; c<n; ++c)
+            {
+                for (int i=0; i<per_child && computation_resources() && !root->best_known; ++i)
+                    iterate(candidates[c]);
+            }
+        }
+
+        if (stop_requested.load(std::memory_order_relaxed))
+            break;
+
+        std::sort(candidates.begin(), candidates.begin() + n, by_value);
+        halving_leader = candidates[0]->move;
+        best_move.store(halving_leader, std::memory_order_relaxed);
+
+        if (!computation_resources() || root->best_known)
+            break;
+
+        n = (n + 1) / 2;
+
+        if (debug_tree)
+            std::cerr << "Halving round done, " << n << " candidates left" << std::endl;
+    }
+
+    return candidates[0];
+}
+
+//****************************** Anytime search ****************************/
+
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::set_update(std::function<void(const SearchInfo&)> callback, int period_ms)
+{
+    on_update     = std::move(callback);
+    update_period = std::max(1, period_ms);
+}
+
+// Called by the owner of the state before starting a search on another thread, so
+// that a stop() coming before create_root() doesn't get the previous search's move.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::reset_best_move()
+{
+    auto& moves = state.valid_actions();
+    bool over   = G::terminal(*state.data) || moves.empty();
+
+    best_move.store(over ? MOVE_NONE : moves[0], std::memory_order_relaxed);
+}
+
+// Called after every iteration: the best move is kept current for stop(), which
+// may come from another thread, and the subscriber is updated when it is time.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::publish()
+{
+    if (root->n_children == 0)
+        return;
+
+    Move best = root->best_known              ? root->children[0].move
+              : halving_leader != MOVE_NONE   ? halving_leader
+                                              : best_final(root)->move;
+    best_move.store(best, std::memory_order_relaxed);
+
+    if (on_update && time_elapsed() >= next_update)
+    {
+        on_update(info());
+        next_update = time_elapsed() + update_period;
+    }
+}
+
+template<Game G, class Selection, class Final>
+SearchInfo BasicAgent<G, Selection, Final>::info()
+{
+    if (cached_info)
+    {
+        SearchInfo si = *cached_info;
+        si.elapsed_ms = time_elapsed();
+        return si;
+    }
+
+    SearchInfo si;
+    si.best_move  = best_so_far();
+    si.iterations = iteration_cnt;
+    si.elapsed_ms = time_elapsed();
+
+    // No root if compact() didn't find it again, the table having been cleared.
+    for (int i=0; root && i<root->n_children; ++i)
+        si.root_visits.emplace_back(root->children[i].move, root->children[i].n_visits);
+
+    // Follow the final policy down the tree, as long as the nodes are known.
+    Node* node = root;
+    while (node && node->n_children > 0 && (int)si.pv.size() < MAX_PLY)
+    {
+        ActionNode* action = node->best_known ? &node->children[0] : best_final(node);
+
+        // At the root of a halving search, the move it plays.
+        for (int i=0; node == root && !node->best_known && i<node->n_children; ++i)
+        {
+            if (node->children[i].move == halving_leader)
+                action = &node->children[i];
+        }
+
+        if (action->n_visits == 0 && !node->best_known)
+            break;
+
+        si.pv.push_back(action->move);
+
+        node = child_hint(action);
+        if (!node && action->child_key && !uses_direct_table())
+            node = find_node<G>(action->child_key);
+    }
+
+    return si;
+}
+
+//****************************** Memory budget *****************************/
+
+// The table's entries, counted as in TableAllocator: the node, the pointer to the
+// next entry of its bucket and the hash code, if the table keeps it.
+template<Game G>
+constexpr size_t ENTRY_BYTES = malloc_bytes(sizeof(typename BasicTable<G>::value_type) + 2 * sizeof(void*));
+
+// The nodes considered by evict(). Allocated with the buckets, for as many nodes as
+// the table holds, so that evicting never needs memory past the budget.
+template<Game G>
+std::vector<std::pair<uint64_t, typename G::key_type>> eviction_candidates;
+
+template<Game G>
+constexpr size_t CANDIDATE_BYTES = sizeof(typename decltype(eviction_candidates<G>)::value_type);
+
+template<class T>
+size_t vector_bytes(const std::vector<T>& v)
+{
+    return v.capacity() ? malloc_bytes(v.capacity() * sizeof(T)) : 0;
+}
+
+// The scratch space of compact(), kept from one call to the next so that the
+// compactions between the moves only allocate when the tree outgrows the largest
+// one so far. The next arena is built here and swapped with game_arena<G>.
+template<Game G>
+struct CompactScratch {
+    std::vector<std::pair<int, BasicNode<G>*>>  frontier;    // A heap, by visits.
+    std::vector<BasicNode<G>*>                  chosen;
+    std::vector<BasicNode<G>*>                  order;
+    std::vector<BasicNode<G>*>                  stack;
+    BasicArena<G>                               arena;
+
+    size_t bytes() const
+    {
+        return vector_bytes(frontier) + vector_bytes(chosen) + vector_bytes(order) + vector_bytes(stack)
+             + vector_bytes(arena.nodes) + vector_bytes(arena.index);
+    }
+};
+
+template<Game G>
+CompactScratch<G> compact_scratch;
+
+template<Game G, class Selection, class Final>
+size_t BasicAgent<G, Selection, Final>::table_bytes()
+{
+    return table_allocated<G>
+         + vector_bytes(direct_nodes<G>)
+         + vector_bytes(game_arena<G>.nodes) + vector_bytes(game_arena<G>.index)
+         + vector_bytes(eviction_candidates<G>)
+         + compact_scratch<G>.bytes();
+}
+
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::clear_table()
+{
+    // Their memory too, not only their elements.
+    BasicTable<G>().swap(game_table<G>);
+    game_arena<G> = BasicArena<G>();
+    direct_nodes<G> = std::vector<Node>();
+    eviction_candidates<G> = decltype(eviction_candidates<G>)();
+    compact_scratch<G> = CompactScratch<G>();
+    ++table_epoch;
+}
+
+// What is left of max_bytes once the buckets, the arena and the scratch spaces of
+// the eviction and the compaction are allocated goes to the nodes. There are no more nodes than buckets, so
+// the table never rehashes.
+template<Game G, class Selection, class Final>
+size_t BasicAgent<G, Selection, Final>::max_nodes()
+{
+    size_t fixed = malloc_bytes(game_table<G>.bucket_count() * sizeof(void*))
+                 + vector_bytes(game_arena<G>.nodes) + vector_bytes(game_arena<G>.index)
+                 + vector_bytes(eviction_candidates<G>) + compact_scratch<G>.bytes();
+
+    if (fixed >= max_bytes)
+        return 0;
+
+    return std::min((max_bytes - fixed) / ENTRY_BYTES<G>, game_table<G>.bucket_count());
+}
+
+// Allocate the buckets (a node per bucket at the default max load factor) and the
+// eviction's scratch space up front, for as many nodes as max_bytes allows.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::reserve_budget()
+{
+    size_t n = max_bytes / (ENTRY_BYTES<G> + CANDIDATE_BYTES<G> + sizeof(void*));
+
+    if (game_table<G>.bucket_count() < n)
+        game_table<G>.reserve(n);
+    if (eviction_candidates<G>.capacity() < n)
+        eviction_candidates<G>.reserve(n);
+}
+
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::make_room()
+{
+    // The direct table holds every position already.
+    if (max_bytes && !uses_direct_table() && game_table<G>.size() >= max_nodes())
+        evict(max_nodes() * 9 / 10);
+}
+
+// Remove nodes until there are only `target` of them left, starting with those
+// of the oldest generations (outside of the current root's subtree) and the least
+// visited ones (the leaves). Nodes along the current descent are never removed.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::evict(size_t target)
+{
+    auto& candidates = eviction_candidates<G>;
+    candidates.clear();
+
+    // The nodes of the descents are kept, marked for the time of the scan.
+    for (Node* node : nodes)
+        if (node)
+            node->compact_mark = 1;
+
+    for (auto& [key, node] : game_table<G>)
+    {
+        if (candidates.size() == candidates.capacity())
+            break;    // Never past the space allocated up front.
+
+        if (node.n_pending > 0 || node.compact_mark)
+            continue;
+
+        uint64_t priority = (uint64_t(node.generation) << 32) | uint32_t(node.n_visits);
+        candidates.emplace_back(priority, key);
+    }
+
+    for (Node* node : nodes)
+        if (node)
+            node->compact_mark = 0;
+
+    size_t n_evict = std::min(candidates.size(), game_table<G>.size() - std::min(target, game_table<G>.size()));
+
+    std::nth_element(candidates.begin(), candidates.begin() + n_evict, candidates.end());
+
+    for (size_t i=0; i<n_evict; ++i)
+        game_table<G>.erase(candidates[i].second);
+
+    evicted_cnt += n_evict;
+    ++table_epoch;
+
+    if (debug_counters)
+        std::cerr << "Evicted " << n_evict << " nodes, " << game_table<G>.size() << " left" << std::endl;
+}
+
+//******************************* Compaction ******************************/
+
+// Rebuild the tree below the current position into game_arena<G>, in depth-first
+// order with the most visited child first. Within a budget (compact_max_nodes, and
+// half of the table when max_bytes is set), the most visited nodes are chosen by a
+// best-first search from the root, then laid out in the same order. The nodes left
+// out, from the table or the previous arena, are in the keyed table afterwards, to
+// be evicted as usual. Returns the number of nodes in the arena.
+//
+// Called between the moves, when compact_tree is set: not by the search itself,
+// whose clock it would spend. The nodes are marked through their compact_mark
+// instead of sets and maps, the rest of the memory is the scratch space's.
+template<Game G, class Selection, class Final>
+size_t BasicAgent<G, Selection, Final>::compact()
+{
+    if (uses_direct_table())
+        return 0;
+
+    constexpr uint32_t CHOSEN = ~uint32_t(0);    // Otherwise 1 + the node's slot once laid out.
+    auto& scratch = compact_scratch<G>;
+
+    size_t budget = compact_max_nodes ? compact_max_nodes : std::numeric_limits<size_t>::max();
+    if (max_bytes)
+        budget = std::min(budget, max_nodes() / 2);
+
+    if (budget < std::numeric_limits<size_t>::max())
+    {
+        scratch.chosen.reserve(budget);
+        scratch.order.reserve(budget);
+        scratch.arena.nodes.reserve(budget);
+        scratch.arena.index.reserve(budget);
+    }
+
+    // The children are looked up before anything moves, the hints being still valid.
+    auto resolve = [this](const ActionNode& a) -> Node* {
+        Node* child = child_hint(&a);
+        return child || !a.child_key ? child : find_node<G>(a.child_key);
+    };
+
+    Node* top = find_node<G>(state.key());
+
+    // The most visited first, then the least key: which nodes fit in the budget
+    // doesn't depend on where the allocator put them.
+    auto by_visits = [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : a.second->key > b.second->key;
+    };
+
+    auto& frontier = scratch.frontier;
+    auto& chosen   = scratch.chosen;
+    frontier.clear();
+    chosen.clear();
+    if (top)
+        frontier.emplace_back(top->n_visits, top);
+
+    while (!frontier.empty() && chosen.size() < budget)
+    {
+        std::pop_heap(frontier.begin(), frontier.end(), by_visits);
+        Node* node = frontier.back().second;
+        frontier.pop_back();
+        if (node->compact_mark)
+            continue;
+
+        node->compact_mark = CHOSEN;
+        chosen.push_back(node);
+
+        for (int i=0; i<node->n_children; ++i)
+        {
+            Node* child = resolve(node->children[i]);
+            if (child && !child->compact_mark)
+            {
+                frontier.emplace_back(child->n_visits, child);
+                std::push_heap(frontier.begin(), frontier.end(), by_visits);
+            }
+        }
+    }
+
+    // Depth first, the most visited child being on top of the stack, the first one of
+    // the edges among equals. A position reached by several paths is laid out where
+    // the first one leads.
+    auto& order = scratch.order;
+    auto& stack = scratch.stack;
+    order.clear();
+    stack.clear();
+    if (top && top->compact_mark)
+        stack.push_back(top);
+
+    while (!stack.empty())
+    {
+        Node* node = stack.back();
+        stack.pop_back();
+        if (node->compact_mark != CHOSEN)
+            continue;
+
+        order.push_back(node);
+        node->compact_mark = order.size();
+
+        std::array<std::tuple<int, int, Node*>, MAX_CHILDREN> next;
+        int n_next = 0;
+        for (int i=0; i<node->n_children; ++i)
+        {
+            Node* child = resolve(node->children[i]);
+            if (child && child->compact_mark == CHOSEN)
+                next[n_next++] = { node->children[i].n_visits, i, child };
+        }
+
+        std::sort(next.begin(), next.begin() + n_next, [](const auto& a, const auto& b){
+                auto [visits_a, index_a, node_a] = a;
+                auto [visits_b, index_b, node_b] = b;
+                return visits_a != visits_b ? visits_a < visits_b : index_a > index_b;
+            });
+        for (int i=0; i<n_next; ++i)
+            stack.push_back(std::get<2>(next[i]));
+    }
+
+    uint32_t epoch = table_epoch + 1;
+    BasicArena<G>& arena = scratch.arena;
+    arena.clear();
+    arena.nodes.reserve(order.size());
+    arena.index.reserve(order.size());
+
+    for (uint32_t i=0; i<order.size(); ++i)
+    {
+        arena.nodes.push_back(*order[i]);
+        arena.nodes[i].compact_mark = 0;
+        arena.index.emplace_back(order[i]->key, i);
+
+        // The edges out of the arena find their node through the table again. The
+        // slots past i aren't filled yet, but the reserved block doesn't move.
+        for (int c=0; c<order[i]->n_children; ++c)
+        {
+            auto& edge  = arena.nodes[i].children[c];
+            Node* child = resolve(order[i]->children[c]);
+            bool inside = child && child->compact_mark;
+
+            edge.child       = inside ? arena.nodes.data() + (child->compact_mark - 1) : nullptr;
+            edge.child_epoch = inside ? epoch : 0;
+        }
+    }
+    std::sort(arena.index.begin(), arena.index.end());
+
+    // The chosen nodes leave the table or the previous arena, their marks with them.
+    for (auto& node : game_arena<G>.nodes)
+    {
+        if (!node.compact_mark)
+            game_table<G>.emplace(node.key, node);
+    }
+    for (Node* node : order)
+    {
+        if (!game_arena<G>.contains(node))
+            game_table<G>.erase(node->key);
+    }
+
+    std::swap(game_arena<G>, arena);
+    arena.clear();
+    table_epoch = epoch;
+
+    // The last search's nodes have moved: its root is looked up again for info(),
+    // the next search starts from a new one anyway.
+    nodes = {};
+    root = nodes[root_ply] = find_node<G>(states[root_ply].key);
+
+    return game_arena<G>.size();
+}
+
+//**************************** Batched evaluation ***************************/
+
+// Descents keep going while a batch is evaluated on another thread, with at
+// most two batches in flight. The oldest one is applied as soon as it is ready,
+// or when nothing else can be done until it is. The thread is the agent's, it
+// is only started again if the evaluator changes.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::search_batched() requires is_tictactoe
+{
+    const size_t MAX_IN_FLIGHT = 2;
+
+    if (!async || &async->target() != evaluator)
+        async = std::make_unique<AsyncEvaluator>(*evaluator);
+
+    std::deque<Batch> in_flight;
+
+    auto is_ready = [](Batch& b) {
+        return b.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+
+    while (true)
+    {
+        bool more = computation_resources() && !root->best_known;
+        bool collided = false;
+
+        if (more && in_flight.size() < MAX_IN_FLIGHT)
+        {
+            Batch batch;
+            collided = collect_batch(batch);
+
+            if (!batch.leaves.empty())
+            {
+                batch.result = async->submit(batch.leaves);
+                in_flight.push_back(std::move(batch));
+            }
+        }
+
+        if (in_flight.empty())
+        {
+            if (more)
+                continue;
+            break;
+        }
+
+        if (!more || collided || in_flight.size() >= MAX_IN_FLIGHT || is_ready(in_flight.front()))
+        {
+            apply_batch(in_flight.front());
+            in_flight.pop_front();
+            publish();
+        }
+    }
+}
+
+// Select up to batch_size leaves, giving a virtual visit to the edges on their
+// path so that the next descents spread out. Terminal and solved leaves don't
+// need the evaluator and are backpropagated right away. Returns true if a
+// descent stopped on a leaf which is already waiting for its evaluation.
+template<Game G, class Selection, class Final>
+bool BasicAgent<G, Selection, Final>::collect_batch(Batch& batch) requires is_tictactoe
+{
+    while ((int)batch.leaves.size() < batch_size && computation_resources() && !root->best_known)
+    {
+        Node* node = tree_policy();
+
+        if (is_terminal(node) || node->best_known)
+        {
+            Reward reward = rollout_policy(node);
+            backpropagate(node, reward);
+            ++iteration_cnt;
+            continue;
+        }
+
+        if (node->n_pending > 0)
+        {
+            for (int p = root_ply; p < ply; ++p)
+                --nodes[p]->n_visits;
+            while (current_node() != root)
+                undo_move();
+
+            return true;
+        }
+
+        PendingLeaf path;
+        path.depth = ply - root_ply;
+
+        for (int p = root_ply; p < ply; ++p)
+        {
+            ActionNode* action = actions[p];
+            ++action->n_visits;
+            ++action->n_pending;
+            action->avg_action_value = action->action_value / action->n_visits;
+
+            path.edges[p - root_ply] = action;
+            path.nodes[p - root_ply] = nodes[p];
+        }
+        path.nodes[path.depth] = node;
+
+        for (int d = 0; d <= path.depth; ++d)
+            ++path.nodes[d]->n_pending;
+
+        Leaf leaf;
+        auto& valid_actions = state.valid_actions();
+        leaf.grid    = state.grid();
+        leaf.to_move = state.next_player();
+        leaf.key     = state.key();
+        leaf.n_moves = std::min<int>(valid_actions.size(), MAX_CHILDREN);
+        std::copy_n(valid_actions.begin(), leaf.n_moves, leaf.moves.begin());
+
+        for (int j=0; j<leaf.n_moves; ++j)
+            path.child_keys[j] = state.key_after(leaf.moves[j]);
+
+        batch.leaves.push_back(leaf);
+        batch.paths.push_back(path);
+
+        while (current_node() != root)
+            undo_move();
+
+        // The root's own evaluation visits no edge.
+        if (path.depth > 0)
+            ++iteration_cnt;
+    }
+
+    return false;
+}
+
+// Expand the leaves with the evaluator's priors, and backpropagate their values
+// along the recorded paths (the visits were already counted by the virtual visits).
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::apply_batch(Batch& batch) requires is_tictactoe
+{
+    std::vector<Evaluation> evals = batch.result.get();
+
+    for (size_t i=0; i<batch.paths.size(); ++i)
+    {
+        const PendingLeaf& path = batch.paths[i];
+        const Leaf& leaf        = batch.leaves[i];
+        const Evaluation& eval  = evals[i];
+        Node* node              = path.nodes[path.depth];
+
+        if (node->n_visits == 0)
+        {
+            for (int j=0; j<leaf.n_moves && j<MAX_CHILDREN; ++j)
+            {
+                ActionNode& a      = node->children[j];
+                a.move             = leaf.moves[j];
+                a.n_visits         = 0;
+                a.prior_value      = eval.priors[j];
+                a.action_value     = 0;
+                a.sq_action_value  = 0;
+                a.avg_action_value = 0;
+                a.decisive         = false;
+                a.n_pending        = 0;
+                a.policy           = eval.priors[j];
+                a.child_key        = path.child_keys[j];
+                a.child            = nullptr;
+                a.child_epoch      = 0;
+            }
+            node->n_children = std::min(leaf.n_moves, (int)MAX_CHILDREN);
+            node->n_expanded_children = node->n_children;
+
+            std::sort(node->children.begin(), node->children.begin() + node->n_children, [](const auto& a, const auto& b){
+                    return a.policy > b.policy;
+                });
+
+            if (node->n_children < MAX_CHILDREN)
+            {
+                node->children[node->n_children]      = ActionNode{};
+                node->children[node->n_children].move = MOVE_END;
+            }
+
+            ++node->n_visits;
+            ++explored_nodes_cnt;
+        }
+
+        Reward r = eval.value;
+
+        for (int d = path.depth - 1; d >= 0; --d)
+        {
+            r = 1.0 - r;
+
+            ActionNode* action = path.edges[d];
+            action->action_value += r;
+            action->sq_action_value += r * r;
+            action->avg_action_value = action->action_value / action->n_visits;
+
+            path.nodes[d+1]->value_sum += r;
+            ++path.nodes[d+1]->n_updates;
+
+            // The other processes get the real visit, the virtual ones stay local
+            // (SharedTable::load() adds them back on top of the shared counts).
+            --action->n_pending;
+            if (shared_table)
+                shared_table->add(path.nodes[d]->key, action->move, 1, r, r * r);
+
+            if (propagate_minimax)
+                r = best_avg_val(path.nodes[d])->avg_action_value;
+        }
+
+        for (int d = 0; d <= path.depth; ++d)
+            --path.nodes[d]->n_pending;
+    }
+}
+
 //***************************** Playing moves ******************************/
 
-Node* Agent::current_node()
+template<Game G, class Selection, class Final>
+auto BasicAgent<G, Selection, Final>::current_node() -> Node*
 {
     return nodes[ply];
 }
 
-bool Agent::is_terminal(Node* node)
+template<Game G, class Selection, class Final>
+bool BasicAgent<G, Selection, Final>::is_terminal(Node* node)
 {
     assert(node == current_node());
-    return key_terminal(states[ply].key);
+    return G::terminal(states[ply]);
 }
 
-void Agent::init_children()
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::init_children()
 {
     //auto& children      = current_node()->children_list();
     assert(current_node()->n_children == 0);
+    Alloc::Scope phase(Alloc::PHASE_EXPANSION);
 
     if (debug_init_children)
     {
         std::cerr << "Initializing children of node\n";
-        Debug::display(std::cerr, state);
+        display(std::cerr, state);
         std::cerr << std::endl;
     }
 
     // Make a local copy because the state's valid_actions
     // container will change during the random simulations.
-    auto valid_actions = state.valid_actions();
+    std::array<Move, G::MAX_MOVES> valid_actions;
+    auto& legal = state.valid_actions();
+    int n_moves = std::min<int>(legal.size(), G::MAX_MOVES);
+    std::copy_n(legal.begin(), n_moves, valid_actions.begin());
 
     if (debug_init_children)
     {
         std::cerr << "With moves ";
-        for (const auto& a : valid_actions) { std::cerr << a << ' '; }
+        for (int i=0; i<n_moves; ++i) { std::cerr << valid_actions[i] << ' '; }
         std::cerr << std::endl;
     }
 
     ++explored_nodes_cnt;
 
-    for (auto move : valid_actions)
+    Node* node = current_node();
+
+    // Near the end of the game, an exact search is cheaper than the rollouts.
+    int empty_cells = G::MAX_GAME_PLY + 1 - state.gamePly;
+    bool perfect = is_tictactoe && perfect_table;
+    bool exact = perfect || empty_cells <= ab_threshold;
+
+    // The moves with their a priori value, when the game gives one. When there are more
+    // moves than a node can hold, the likeliest ones are kept.
+    std::array<std::pair<Reward, Move>, G::MAX_MOVES> moves;
+    int n_kept  = std::min<int>(n_moves, MAX_CHILDREN - 1);
+
+    for (int i=0; i<n_moves; ++i)
     {
-        assert(move != MOVE_NONE);
+        Reward p = 0.5;
+        if constexpr (HasPrior<G>)
+            p = state.prior(valid_actions[i]);
+        moves[i] = { p, valid_actions[i] };
+    }
 
-        // std::cerr << "Starting random simulation at ply " << ply << " and state \n";
-        // Debug::display(std::cerr, state);
-        // std::cerr << std::endl;
+    if constexpr (HasPrior<G>)
+        std::partial_sort(moves.begin(), moves.begin() + n_kept, moves.begin() + n_moves, [](const auto& a, const auto& b){
+                return a.first > b.first;
+            });
 
-        Reward prior = random_simulation(move);
-        ++rollout_cnt;
+    // With progressive widening, only the children considered at first are evaluated,
+    // the next ones are as the visits let them in (see widen()).
+    int n_evaluated = exact ? n_kept : std::min(n_kept, widening_at(1));
+    bool batched = is_tictactoe && simd_playouts && !exact;
+    double policy_sum = 0;
+
+    for (int i=0; i<n_kept; ++i)
+    {
+        auto [p, move] = moves[i];
+        assert(move != MOVE_NONE);
 
-        ActionNode new_action;
+        ActionNode& new_action = node->children_list()[i];
         new_action.move = move;
         new_action.n_visits = 0;
-        new_action.prior_value = prior;
+        new_action.prior_value = i < n_evaluated && !batched ? evaluate_move(move, exact, empty_cells) : p;
         new_action.action_value = 0;
+        new_action.sq_action_value = 0;
         new_action.avg_action_value = 0;
+        new_action.decisive = exact && new_action.prior_value == 1;
+        new_action.n_pending = 0;
+        new_action.policy = p;
+        new_action.child_key = state.key_after(move);
+        new_action.child = nullptr;
+        new_action.child_epoch = 0;
+
+        policy_sum += p;
+    }
 
-        if (current_node()->n_children < MAX_CHILDREN)
-        {
-            current_node()->children_list()[current_node()->n_children] = new_action;
-            ++(current_node()->n_children);
-        }
+    node->n_children = n_kept;
+    node->n_expanded_children = n_evaluated;
+
+    if constexpr (is_tictactoe)
+    {
+        if (batched)
+            batch_priors(node, n_evaluated);
     }
 
     if (debug_init_children)
         std::cerr << "initialized all children" << std::endl;
 
-    ++current_node()->n_visits;
+    // Uniform, unless the game gives priors.
+    for (int i=0; i<node->n_children; ++i)
+        node->children[i].policy = policy_sum > 0 ? node->children[i].policy / policy_sum : 1.0 / node->n_children;
+
+    ++node->n_visits;
+
+    if (exact)
+    {
+        node->best_known = true;
+        ++solved_nodes_cnt;
+    }
 
-    std::sort(current_node()->children_list().begin(), current_node()->children_list().begin() + current_node()->n_children, [](const auto& a, const auto& b){
+    std::sort(node->children_list().begin(), node->children_list().begin() + n_evaluated, [](const auto& a, const auto& b){
             return a.prior_value > b.prior_value;
         });
 
-    // A sentinel to easily iterate through children.
+    // A sentinel to easily iterate through children, with every field zeroed.
     if (current_node()->n_children < MAX_CHILDREN)
     {
-        ActionNode new_action;
+        ActionNode new_action{};
         new_action.move = MOVE_END;
-        new_action.n_visits = 0;
-        new_action.prior_value = 0;
-        new_action.action_value = 0;
-        new_action.avg_action_value = 0;
 
         current_node()->children_list()[current_node()->n_children] = new_action;
     }
 }
 
-void Agent::apply_move(Move move)
+// The value of a move for the player making it: exact from the perfect table or by
+// alpha-beta near the end of the game, the mean of n_rollouts random simulations otherwise.
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::evaluate_move(Move move, bool exact, int empty_cells)
+{
+    Alloc::Scope phase(Alloc::PHASE_SIMULATION);
+
+    if constexpr (is_tictactoe)
+    {
+        if (exact && perfect_table)
+            return perfect_table->reward(state, move);
+    }
+
+    Reward prior = 0;
+    if (exact)
+    {
+        apply_move(move);
+        prior = 1 - alpha_beta(0, 1, empty_cells - 1);
+        undo_move(move);
+        return prior;
+    }
+
+    for (int i=0; i<n_rollouts; ++i)
+    {
+        prior += random_simulation(move);
+        ++rollout_cnt;
+    }
+    return prior / n_rollouts;
+}
+
+// The n_rollouts playouts of each of the first n children, in one call of the
+// playout kernel.
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::batch_priors(Node* node, int n) requires is_tictactoe
+{
+    Token us = state.next_player(), them = Token(3 - us);
+    uint16_t ours = state.stones(us), theirs = state.stones(them);
+
+    playout_boards.clear();
+    for (int i=0; i<n; ++i)
+    {
+        uint16_t bit = 1 << State::moveToCell(node->children[i].move);
+        for (int j=0; j<n_rollouts; ++j)
+            playout_boards.push_back({ theirs, uint16_t(ours | bit) });
+    }
+
+    playout_values.resize(playout_boards.size());
+    Playout::run(playout_boards.data(), playout_boards.size(), playout_values.data(), rng());
+    rollout_cnt += playout_boards.size();
+
+    // The values are for the opponent, who moves next.
+    for (int i=0; i<n; ++i)
+    {
+        Reward prior = 0;
+        for (int j=0; j<n_rollouts; ++j)
+            prior += 1 - playout_values[i * n_rollouts + j];
+        node->children[i].prior_value = prior / n_rollouts;
+    }
+}
+
+// The mean of k playouts from the current position, for the player to move.
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::batch_playouts(int k) requires is_tictactoe
+{
+    Token us = state.next_player();
+    playout_boards.assign(k, { state.stones(us), state.stones(Token(3 - us)) });
+
+    playout_values.resize(k);
+    Playout::run(playout_boards.data(), k, playout_values.data(), rng());
+    rollout_cnt += k;
+
+    Reward r = 0;
+    for (Reward v : playout_values)
+        r += v;
+    return r / k;
+}
+
+// Progressive widening: after n visits, a node considers widening_cst * n^widening_exp
+// of its children. They come in by prior, each one being evaluated when it does, so the
+// cost of an expansion stays bounded however many moves there are, and all of them are
+// reached as the visits grow (the m,n,k-games keep every move as a child).
+template<Game G, class Selection, class Final>
+int BasicAgent<G, Selection, Final>::widening_at(int n_visits) const
+{
+    if (widening_cst <= 0)
+        return max_children<G>();
+
+    double n = std::ceil(widening_cst * std::pow(n_visits, widening_exp));
+    return (int)std::clamp(n, 1.0, (double)max_children<G>());
+}
+
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::widen(Node* node)
+{
+    assert(node == current_node());
+    assert(node->n_children <= max_children<G>());
+
+    int target = std::min(node->n_children, widening_at(node->n_visits));
+    int empty_cells = G::MAX_GAME_PLY + 1 - state.gamePly;
+
+    while (node->n_expanded_children < target)
+    {
+        auto& c = node->children[node->n_expanded_children++];
+        c.prior_value = evaluate_move(c.move, false, empty_cells);
+    }
+}
+
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::apply_move(Move move)
 {
     ++ply;
     state.apply_move(move, states[ply]);
 }
 
-void Agent::undo_move()
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::undo_move()
 {
     --ply;
     state.undo_move(actions[ply]->move);
 }
 
 // For using the search stack instead of the node stack.
-void Agent::undo_move(Move move)
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::undo_move(Move move)
 {
     --ply;
     state.undo_move(move);
@@ -504,11 +1760,12 @@ void Agent::undo_move(Move move)
 //
 // First idea would be to not save or lookup anything, but save the next-to-last state
 // (really, state-before-known-win/lose) to start building a table of alphas and betas.
-Reward Agent::random_simulation(Move move)
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::random_simulation(Move move)
 {
     if (debug_random_sim)
     {
-        Debug::display(std::cerr, state);
+        display(std::cerr, state);
         std::cerr << std::endl;
         std::cerr << "Random simulation, ply " << ply << ", next move is " << move << std::endl;
     }
@@ -519,17 +1776,17 @@ Reward Agent::random_simulation(Move move)
 
     apply_move(move);
 
-    if (key_terminal(states[ply].key))
+    if (G::terminal(states[ply]))
     {
         if (debug_random_sim)
         {
-            Debug::display(std::cerr, state);
+            display(std::cerr, state);
             std::cerr << std::endl;
             std::cerr << "Reached terminal state at ply " << ply << std::endl;
-            std::cerr << "Evaluation : " << std::fixed << key_ev_terminal(states[ply])  << std::endl;
+            std::cerr << "Evaluation : " << std::fixed << G::terminal_value(states[ply])  << std::endl;
         }
 
-        stackBuf[ply-1].r += key_ev_terminal(states[ply]);
+        stackBuf[ply-1].r += G::terminal_value(states[ply]);
     } else
     {
         Move m = Random::choose(state.valid_actions());
@@ -548,14 +1805,179 @@ Reward Agent::random_simulation(Move move)
     return stackBuf[ply].r;
 }
 
+// Negamax with alpha-beta pruning, the values being rewards in [0, 1] from the
+// point of view of the side to move, so a child's window is (1 - beta, 1 - alpha).
+// Positions are cached in ab_table since transpositions are frequent at the leaves.
+template<Game G, class Selection, class Final>
+Reward BasicAgent<G, Selection, Final>::alpha_beta(Reward alpha, Reward beta, int depth)
+{
+    const Data& sd = states[ply];
+
+    if (G::terminal(sd))
+        return 1 - G::terminal_value(sd);
+
+    if (depth == 0)
+        return 0.5;
+
+    ABEntry* tte = ab_table[sd.key];
+    if (tte->key == sd.key && tte->depth >= depth)
+    {
+        if (tte->bound == ABEntry::BOUND_EXACT
+            || (tte->bound == ABEntry::BOUND_LOWER && tte->value >= beta)
+            || (tte->bound == ABEntry::BOUND_UPPER && tte->value <= alpha))
+            return tte->value;
+    }
+
+    // The state's valid_actions container is reused by the recursive calls. All the
+    // moves are searched, not only the ones a node would keep, for the value to be exact.
+    std::array<Move, G::MAX_MOVES> moves;
+    auto& valid_actions = state.valid_actions();
+    int n_moves = valid_actions.size();
+    assert(n_moves <= G::MAX_MOVES);
+    std::copy_n(valid_actions.begin(), n_moves, moves.begin());
+
+    Reward alpha_orig = alpha;
+    Reward best = 0;
+
+    for (int i=0; i<n_moves; ++i)
+    {
+        apply_move(moves[i]);
+        Reward r = 1 - alpha_beta(1 - beta, 1 - alpha, depth - 1);
+        undo_move(moves[i]);
+
+        best  = std::max(best, r);
+        alpha = std::max(alpha, r);
+        if (alpha >= beta)
+            break;
+    }
+
+    tte->key   = sd.key;
+    tte->value = best;
+    tte->depth = depth;
+    tte->bound = best <= alpha_orig ? ABEntry::BOUND_UPPER
+               : best >= beta       ? ABEntry::BOUND_LOWER
+                                    : ABEntry::BOUND_EXACT;
+
+    return best;
+}
+
+//************************************** PROFILES ****************************************/
+
+bool AgentBase::save_profile(const std::string& path)
+{
+    std::ofstream ofs(path);
+    if (!ofs)
+        return false;
+
+    ofs << "exploration_cst " << exploration_cst << '\n'
+        << "propagate_minimax " << propagate_minimax << '\n'
+        << "n_rollouts " << n_rollouts << '\n'
+        << "leaf_playouts " << leaf_playouts << '\n'
+        << "playouts_decay " << playouts_decay << '\n'
+        << "ab_threshold " << ab_threshold << '\n'
+        << "graph_search " << graph_search << '\n'
+        << "max_bytes " << max_bytes << '\n'
+        << "max_iter " << MAX_ITER << '\n'
+        << "max_time " << MAX_TIME << '\n'
+        << "use_time " << use_time << '\n'
+        << "root_halving " << root_halving << '\n'
+        << "halving_top_k " << halving_top_k << '\n'
+        << "puct_cst " << puct_cst << '\n'
+        << "widening_cst " << widening_cst << '\n'
+        << "widening_exp " << widening_exp << '\n'
+        << "simd_playouts " << simd_playouts << '\n'
+        << "direct_table " << direct_table << '\n'
+        << "compact_tree " << compact_tree << '\n'
+        << "compact_max_nodes " << compact_max_nodes << '\n'
+        << "batch_size " << batch_size << '\n';
+
+    return bool(ofs);
+}
+
+// The knobs of the profile, but the budget (a key of its own) and the ones only
+// changing the layout of the nodes, and the evaluators of the leaves.
+uint64_t AgentBase::profile_hash()
+{
+    uint64_t h = 0;
+    auto add = [&h](auto knob) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &knob, std::min(sizeof(knob), sizeof(bits)));
+        h = (h ^ bits) * 0x100000001B3ULL + 0x9E3779B97F4A7C15ULL;
+    };
+
+    add(exploration_cst);  add(propagate_minimax); add(n_rollouts);    add(leaf_playouts);
+    add(playouts_decay);   add(ab_threshold);      add(graph_search);  add(max_bytes);
+    add(root_halving);     add(halving_top_k);     add(puct_cst);      add(widening_cst);
+    add(widening_exp);     add(simd_playouts);     add(batch_size);
+    add(evaluator);        add(perfect_table);     add(warm_start);    add(shared_table);
+
+    return h;
+}
+
+// Sets one of the knobs from its textual value, returns false if the name is unknown.
+bool AgentBase::set_option(const std::string& name, const std::string& value)
+{
+    std::istringstream is(value);
+
+    if (name == "exploration_cst")        is >> exploration_cst;
+    else if (name == "propagate_minimax") is >> propagate_minimax;
+    else if (name == "n_rollouts")        is >> n_rollouts;
+    else if (name == "leaf_playouts")     is >> leaf_playouts;
+    else if (name == "playouts_decay")    is >> playouts_decay;
+    else if (name == "ab_threshold")      is >> ab_threshold;
+    else if (name == "graph_search")      is >> graph_search;
+    else if (name == "max_bytes")         is >> max_bytes;
+    else if (name == "max_iter")          is >> MAX_ITER;
+    else if (name == "max_time")          is >> MAX_TIME;
+    else if (name == "use_time")          is >> use_time;
+    else if (name == "root_halving")      is >> root_halving;
+    else if (name == "halving_top_k")     is >> halving_top_k;
+    else if (name == "puct_cst")          is >> puct_cst;
+    else if (name == "widening_cst")      is >> widening_cst;
+    else if (name == "widening_exp")      is >> widening_exp;
+    else if (name == "simd_playouts")     is >> simd_playouts;
+    else if (name == "direct_table")      is >> direct_table;
+    else if (name == "trace_search")      is >> trace_search;
+    else if (name == "compact_tree")      is >> compact_tree;
+    else if (name == "compact_max_nodes") is >> compact_max_nodes;
+    else if (name == "batch_size")        is >> batch_size;
+    else
+        return false;
+
+    n_rollouts = std::max(1, n_rollouts);
+    batch_size = std::max(1, batch_size);
+
+    return true;
+}
+
+// Unknown names are skipped so that older binaries can read newer profiles.
+bool AgentBase::load_profile(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs)
+        return false;
+
+    std::string name, value;
+    while (ifs >> name)
+    {
+        std::getline(ifs, value);
+        if (name[0] != '#')
+            set_option(name, value);
+    }
+
+    return !ifs.bad();
+}
 
 //************************************** DEBUGGING ***************************************/
 
-void Agent::set_exp_c(double c) { Agent::exploration_cst = c; }
-void Agent::set_max_time(int t) { Agent::MAX_TIME = t;  }
-void Agent::set_max_iter(int i) { Agent::MAX_ITER = i; }
+void AgentBase::set_exp_c(double c) { AgentBase::exploration_cst = c; }
+void AgentBase::set_max_time(int t) { AgentBase::MAX_TIME = t;  }
+void AgentBase::set_search_time(int t) { AgentBase::MAX_TIME = t + TIME_MARGIN; }
+void AgentBase::set_max_iter(int i) { AgentBase::MAX_ITER = i; }
+void AgentBase::set_backpropagate_minimax(bool b) { AgentBase::propagate_minimax = b; }
 
-void Agent::print_node(std::ostream& _out, Node* node) const
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::print_node(std::ostream& _out, Node* node) const
 {
     _out << "Node: v=" << node->n_visits << std::endl;
     for (int i=0; i<node->n_children; ++i)
@@ -565,7 +1987,8 @@ void Agent::print_node(std::ostream& _out, Node* node) const
     }
 }
 
-void Agent::print_tree(std::ostream& _out, int depth) const
+template<Game G, class Selection, class Final>
+void BasicAgent<G, Selection, Final>::print_tree(std::ostream& _out, int depth) const
 {
     print_node(_out, root);
 }
@@ -580,4 +2003,18 @@ void Agent::print_tree(std::ostream& _out, int depth) const
 //     return r;
 // }
 
+//************************** Explicit instantiations ***********************/
+
+template class BasicAgent<State, Policy::UCB1,      Policy::MostVisits>;
+template class BasicAgent<State, Policy::UCB1,      Policy::BestValue>;
+template class BasicAgent<State, Policy::UCB1Tuned, Policy::MostVisits>;
+template class BasicAgent<State, Policy::UCB1Tuned, Policy::BestValue>;
+template class BasicAgent<State, Policy::Thompson,  Policy::MostVisits>;
+template class BasicAgent<State, Policy::Thompson,  Policy::BestValue>;
+template class BasicAgent<State, Policy::PUCT,      Policy::MostVisits>;
+template class BasicAgent<State, Policy::PUCT,      Policy::BestValue>;
+
+template class BasicAgent<ConnectFour, Policy::UCB1, Policy::MostVisits>;
+template class BasicAgent<Gomoku,      Policy::UCB1, Policy::MostVisits>;
+
 } // namespace mcts
@@ -0,0 +1,269 @@
+
+#include <assert.h>
+#include <cstdlib>
+#include "mnk.h"
+
+namespace mcts {
+
+namespace {
+
+    // Along a row, a column, and the two diagonals.
+    template<int STRIDE>
+    constexpr std::array<int, 4> DIRECTIONS = { 1, STRIDE, STRIDE - 1, STRIDE + 1 };
+
+}  // namespace
+
+//******************************  Util functions  **********************/
+
+/**
+ * Moves are the squares, indexed starting at 1 since MOVE(0) is MOVE_NONE.
+ * The squares are the bits of the boards, with the sentinel columns.
+ */
+template<int M, int N, int K>
+int MNKGame<M, N, K>::moveToSquare(Move m)
+{
+    return (m - 1) / N * STRIDE + (m - 1) % N;
+}
+
+template<int M, int N, int K>
+Move MNKGame<M, N, K>::rowColToMove(int row, int col)
+{
+    return Move(1 + row * N + col);
+}
+
+//*********************************  State  ******************************/
+
+template<int M, int N, int K>
+MNKGame<M, N, K>::MNKGame()
+    : gamePly(1)
+{
+    m_valid_actions.reserve(MAX_MOVES);
+
+    m_start.key = 0;
+    m_start.gamePly = 1;
+    m_start.previous = nullptr;
+    data = &m_start;
+}
+
+template<int M, int N, int K>
+MNKGame<M, N, K>::MNKGame(const MNKGame& other)
+    : data(&m_start)
+    , gamePly(other.gamePly)
+    , m_board(other.m_board)
+{
+    m_valid_actions.reserve(MAX_MOVES);
+
+    start_from(m_start, *other.data);
+}
+
+template<int M, int N, int K>
+MNKGame<M, N, K>& MNKGame<M, N, K>::operator=(const MNKGame& other)
+{
+    if (this != &other)
+    {
+        gamePly = other.gamePly;
+        m_board = other.m_board;
+        data = start_from(m_start, *other.data);
+    }
+    return *this;
+}
+
+template<int M, int N, int K>
+Key MNKGame<M, N, K>::key() const
+{
+    return data->key;
+}
+
+template<int M, int N, int K>
+Key MNKGame<M, N, K>::key_after(Move m) const
+{
+    int square  = moveToSquare(m);
+    Token token = next_player();
+
+    bool win  = wins_with(token, square);
+    bool full = gamePly >= MAX_GAME_PLY;
+
+    Key key = data->key ^ KEYS[(token - 1) * BITS + square] ^ Zobrist::sideKey;
+    key ^= status_bits(win, full);
+
+    return key;
+}
+
+template<int M, int N, int K>
+Token MNKGame<M, N, K>::next_player() const
+{
+    return gamePly & 1 ? X : O;
+}
+
+template<int M, int N, int K>
+bool MNKGame<M, N, K>::is_full() const
+{
+    return gamePly > MAX_GAME_PLY;
+}
+
+template<int M, int N, int K>
+bool MNKGame<M, N, K>::is_valid(Move move) const
+{
+    if (move < 1 || move > MAX_MOVES)
+        return false;
+
+    int square = moveToSquare(move);
+    return !m_board[0].test(square) && !m_board[1].test(square);
+}
+
+template<int M, int N, int K>
+std::vector<Move>& MNKGame<M, N, K>::valid_actions()
+{
+    m_valid_actions.clear();
+
+    if (is_terminal())
+    {
+        return m_valid_actions;
+    }
+
+    auto occupied = m_board[0] | m_board[1];
+    for (int r=0; r<M; ++r)
+    {
+        for (int c=0; c<N; ++c)
+        {
+            if (!occupied.test(r * STRIDE + c))
+                m_valid_actions.push_back(rowColToMove(r, c));
+        }
+    }
+    return m_valid_actions;
+}
+
+// Counts the stones around the square, the adjacent ones twice, with the
+// distance to the center to break the ties on an empty board.
+template<int M, int N, int K>
+Reward MNKGame<M, N, K>::prior(Move m) const
+{
+    int row = (m - 1) / N, col = (m - 1) % N;
+    auto occupied = m_board[0] | m_board[1];
+
+    int near = 0;
+    for (int r = std::max(0, row - 2); r <= std::min(M - 1, row + 2); ++r)
+    {
+        for (int c = std::max(0, col - 2); c <= std::min(N - 1, col + 2); ++c)
+        {
+            if (occupied.test(r * STRIDE + c))
+                near += std::max(std::abs(r - row), std::abs(c - col)) == 1 ? 2 : 1;
+        }
+    }
+
+    double center = 1.0 - double(std::abs(2 * row - (M - 1)) + std::abs(2 * col - (N - 1))) / (M + N);
+
+    return (near + center) / 33;    // 8 adjacent squares counting 2, 16 at distance 2.
+}
+
+// The runs through the square, in both ways of each direction. The sentinel
+// columns end the runs along the rows and the diagonals.
+template<int M, int N, int K>
+bool MNKGame<M, N, K>::wins_with(Token token, int square) const
+{
+    const bitboard_t& b = m_board[token - 1];
+
+    for (int d : DIRECTIONS<STRIDE>)
+    {
+        int n = 1;
+        for (int s = square + d; s < BITS && b.test(s) && n < K; s += d)
+            ++n;
+        for (int s = square - d; s >= 0 && b.test(s) && n < K; s -= d)
+            ++n;
+        if (n >= K)
+            return true;
+    }
+    return false;
+}
+
+template<int M, int N, int K>
+bool MNKGame<M, N, K>::is_win(const bitboard_t& b)
+{
+    for (int d : DIRECTIONS<STRIDE>)
+    {
+        bitboard_t run = b;
+        for (int i=1; i<K && run.any(); ++i)
+            run = run & b.shifted(-i * d);
+        if (run.any())
+            return true;
+    }
+    return false;
+}
+
+template<int M, int N, int K>
+Token MNKGame<M, N, K>::winner() const
+{
+    if (is_win(m_board[X - 1])) { return X; }
+    if (is_win(m_board[O - 1])) { return O; }
+    return TOK_EMPTY;
+}
+
+// The status is kept in the key, see key_terminal().
+template<int M, int N, int K>
+bool MNKGame<M, N, K>::is_terminal() const
+{
+    return key_terminal(data->key);
+}
+
+template<int M, int N, int K>
+bool MNKGame<M, N, K>::is_draw() const
+{
+    return is_full() && winner() == TOK_EMPTY;
+}
+
+template<int M, int N, int K>
+void MNKGame<M, N, K>::apply_move(Move m, StateData& new_sd)
+{
+    Key key = data->key;
+    new_sd.gamePly = gamePly + 1;
+    new_sd.previous = data;
+    data = &(new_sd);
+
+    assert(is_valid(m));
+    Token token = next_player();
+    int square  = moveToSquare(m);
+
+    // Only the player who just moved can have won, through the new stone.
+    bool win = wins_with(token, square);
+    m_board[token - 1].set(square);
+    ++gamePly;
+
+    key ^= KEYS[(token - 1) * BITS + square];
+    key ^= Zobrist::sideKey;
+    key ^= status_bits(win, is_full());
+
+    data->key = key;
+}
+
+template<int M, int N, int K>
+void MNKGame<M, N, K>::undo_move(Move m)
+{
+    --gamePly;
+    int square = moveToSquare(m);
+    assert(m_board[next_player() - 1].test(square));
+    m_board[next_player() - 1].reset(square);
+
+    data = data->previous;
+}
+
+template<int M, int N, int K>
+auto MNKGame<M, N, K>::board(Token token) const -> const bitboard_t&
+{
+    return m_board[token - 1];
+}
+
+template<int M, int N, int K>
+Token MNKGame<M, N, K>::at(int row, int col) const
+{
+    int square = row * STRIDE + col;
+    return m_board[X - 1].test(square) ? X
+         : m_board[O - 1].test(square) ? O
+                                       : TOK_EMPTY;
+}
+
+//************************** Explicit instantiations ***********************/
+
+template class MNKGame<3, 3, 3>;
+template class MNKGame<15, 15, 5>;
+
+} // namespace mcts
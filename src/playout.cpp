@@ -0,0 +1,210 @@
+#include <array>
+#include <utility>
+#include "playout.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PLAYOUT_X86
+#include <immintrin.h>
+#endif
+
+namespace mcts {
+
+namespace Playout {
+
+namespace {
+
+    constexpr uint32_t FULL = 0x1FF;
+
+    constexpr std::array<uint32_t, 8> WIN_MASKS = {
+        0x007, 0x038, 0x1C0,    // Rows
+        0x049, 0x092, 0x124,    // Columns
+        0x111, 0x054            // Diagonals
+    };
+
+    // Cells of the masks, SELECT[mask * 16 + k] being the k-th empty cell of
+    // `mask`. The padding lets the gathers read 4 bytes from the last entry.
+    struct SelectTable {
+        alignas(64) uint8_t cell[512 * 16 + 4] {};
+        alignas(64) int32_t count[512] {};
+
+        constexpr SelectTable() {
+            for (int m = 0; m < 512; ++m)
+            {
+                int k = 0;
+                for (int c = 0; c < 9; ++c)
+                    if (m >> c & 1)
+                        cell[m * 16 + k++] = c;
+                count[m] = k;
+            }
+        }
+    };
+
+    constexpr SelectTable TABLE;
+
+    // splitmix64, so that neighbouring boards get unrelated generators.
+    uint32_t board_seed(uint64_t seed, int i)
+    {
+        uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return uint32_t(z ^ (z >> 31)) | 1;    // xorshift32 never leaves 0.
+    }
+
+    constexpr uint32_t xorshift(uint32_t x)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    }
+
+    constexpr bool is_win(uint32_t stones)
+    {
+        for (uint32_t m : WIN_MASKS)
+            if ((stones & m) == m)
+                return true;
+        return false;
+    }
+
+}  // namespace
+
+bool has_avx2()
+{
+#ifdef PLAYOUT_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+void run(const Board* boards, int n, Reward* values, uint64_t seed)
+{
+    if (has_avx2())
+        run_avx2(boards, n, values, seed);
+    else
+        run_scalar(boards, n, values, seed);
+}
+
+//******************************** Scalar ********************************/
+
+// One board at a time. `parity` tells if `cur` holds the stones of the player
+// to move in the board, or those of the other one.
+void run_scalar(const Board* boards, int n, Reward* values, uint64_t seed)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        uint32_t cur = boards[i].to_move, opp = boards[i].moved;
+        uint32_t rng = board_seed(seed, i);
+        int parity = 0;
+
+        for (;;)
+        {
+            if (is_win(opp))
+            {
+                values[i] = parity ? 1 : 0;
+                break;
+            }
+            if ((cur | opp) == FULL)
+            {
+                values[i] = 0.5;
+                break;
+            }
+
+            rng = xorshift(rng);
+            uint32_t empty = ~(cur | opp) & FULL;
+            uint32_t k = ((rng >> 16) * TABLE.count[empty]) >> 16;
+
+            cur |= 1u << TABLE.cell[empty * 16 + k];
+            std::swap(cur, opp);
+            parity ^= 1;
+        }
+    }
+}
+
+//********************************* AVX2 *********************************/
+
+// The same steps as run_scalar() on eight boards, the lanes over being masked
+// out until the eight of them are. A game has at most 9 moves, so 10 steps.
+#ifdef PLAYOUT_X86
+__attribute__((target("avx2")))
+void run_avx2(const Board* boards, int n, Reward* values, uint64_t seed)
+{
+    const __m256i full = _mm256_set1_epi32(FULL);
+    const __m256i one  = _mm256_set1_epi32(1);
+    const __m256i two  = _mm256_set1_epi32(2);
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+
+    __m256i masks[8];
+    for (int w = 0; w < 8; ++w)
+        masks[w] = _mm256_set1_epi32(WIN_MASKS[w]);
+
+    for (int g = 0; g < n; g += 8)
+    {
+        alignas(32) int32_t cur_a[8], opp_a[8], rng_a[8], val_a[8];
+
+        // The lanes past the end get a full board, over at once.
+        for (int j = 0; j < 8; ++j)
+        {
+            bool in = g + j < n;
+            cur_a[j] = in ? boards[g + j].to_move : 0;
+            opp_a[j] = in ? boards[g + j].moved : FULL;
+            rng_a[j] = in ? board_seed(seed, g + j) : 1;
+        }
+
+        __m256i cur    = _mm256_load_si256((const __m256i*)cur_a);
+        __m256i opp    = _mm256_load_si256((const __m256i*)opp_a);
+        __m256i rng    = _mm256_load_si256((const __m256i*)rng_a);
+        __m256i active = _mm256_set1_epi32(-1);
+        __m256i parity = _mm256_setzero_si256();
+        __m256i value  = _mm256_setzero_si256();    // In half points.
+
+        for (int step = 0; step < 10; ++step)
+        {
+            __m256i win = _mm256_setzero_si256();
+            for (const auto& m : masks)
+                win = _mm256_or_si256(win, _mm256_cmpeq_epi32(_mm256_and_si256(opp, m), m));
+
+            __m256i stones   = _mm256_or_si256(cur, opp);
+            __m256i won      = _mm256_and_si256(active, win);
+            __m256i drawn    = _mm256_andnot_si256(win, _mm256_and_si256(active, _mm256_cmpeq_epi32(stones, full)));
+
+            value  = _mm256_or_si256(value, _mm256_and_si256(won, _mm256_and_si256(parity, two)));
+            value  = _mm256_or_si256(value, _mm256_and_si256(drawn, one));
+            active = _mm256_andnot_si256(_mm256_or_si256(won, drawn), active);
+
+            if (_mm256_testz_si256(active, active))
+                break;
+
+            rng = _mm256_xor_si256(rng, _mm256_slli_epi32(rng, 13));
+            rng = _mm256_xor_si256(rng, _mm256_srli_epi32(rng, 17));
+            rng = _mm256_xor_si256(rng, _mm256_slli_epi32(rng, 5));
+
+            __m256i empty = _mm256_andnot_si256(stones, full);
+            __m256i count = _mm256_i32gather_epi32(TABLE.count, empty, 4);
+            __m256i k     = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(rng, 16), count), 16);
+            __m256i idx   = _mm256_add_epi32(_mm256_slli_epi32(empty, 4), k);
+            __m256i cell  = _mm256_and_si256(_mm256_i32gather_epi32((const int*)TABLE.cell, idx, 1), byte);
+            __m256i bit   = _mm256_and_si256(_mm256_sllv_epi32(one, cell), active);
+
+            __m256i moved = _mm256_or_si256(cur, bit);
+            cur    = opp;
+            opp    = moved;
+            parity = _mm256_xor_si256(parity, _mm256_set1_epi32(-1));
+        }
+
+        _mm256_store_si256((__m256i*)val_a, value);
+        for (int j = 0; j < 8 && g + j < n; ++j)
+            values[g + j] = 0.5 * val_a[j];
+    }
+}
+#else
+void run_avx2(const Board* boards, int n, Reward* values, uint64_t seed)
+{
+    run_scalar(boards, n, values, seed);
+}
+#endif
+
+}  // namespace Playout
+
+}  // namespace mcts
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "records.h"
+
+namespace mcts {
+
+namespace {
+
+    constexpr char MAGIC[8] = { 'M', 'C', 'T', 'S', 'G', 'A', 'M', 'E' };
+
+}  // namespace
+
+void GameRecord::add(Move move, const SearchInfo& si)
+{
+    if (n_plies >= MAX_PLIES)
+        return;
+
+    Ply& ply = plies[n_plies++];
+    ply.cell = State::moveToCell(move);
+    for (const auto& [m, n] : si.root_visits)
+        ply.visits[State::moveToCell(m)] = n;
+
+    iterations += si.iterations;
+}
+
+//********************************* Codec *********************************/
+
+namespace Records {
+
+void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    out.clear();
+    size_t i = 0;
+
+    while (i < size)
+    {
+        size_t run = 0;
+        while (i + run < size && data[i + run] == 0 && run < 128)
+            ++run;
+
+        if (run >= 2)
+        {
+            out.push_back(uint8_t(127 + run));
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next pair of zeros.
+        size_t n = 0;
+        while (i + n < size && n < 128 && !(data[i + n] == 0 && i + n + 1 < size && data[i + n + 1] == 0))
+            ++n;
+        n = std::max<size_t>(n, 1);
+
+        out.push_back(uint8_t(n - 1));
+        out.insert(out.end(), data + i, data + i + n);
+        i += n;
+    }
+}
+
+bool decompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size)
+{
+    size_t i = 0, o = 0;
+
+    while (i < size)
+    {
+        uint8_t c = data[i++];
+        if (c >= 128)
+        {
+            size_t run = c - 127;
+            if (o + run > out_size)
+                return false;
+            std::memset(out + o, 0, run);
+            o += run;
+        }
+        else
+        {
+            size_t n = c + 1;
+            if (i + n > size || o + n > out_size)
+                return false;
+            std::memcpy(out + o, data + i, n);
+            i += n;
+            o += n;
+        }
+    }
+    return o == out_size;
+}
+
+}  // namespace Records
+
+//********************************* Writing *******************************/
+
+RecordWriter::Buffer::Buffer(RecordWriter& writer)
+    : writer(writer)
+{
+    records.reserve(BLOCK_RECORDS);
+}
+
+RecordWriter::Buffer::~Buffer()
+{
+    flush();
+}
+
+void RecordWriter::Buffer::add(const GameRecord& record)
+{
+    records.push_back(record);
+    if (records.size() >= BLOCK_RECORDS)
+        flush();
+}
+
+void RecordWriter::Buffer::flush()
+{
+    if (records.empty())
+        return;
+
+    writer.submit(std::move(records));
+    records = {};
+    records.reserve(BLOCK_RECORDS);
+}
+
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+bool RecordWriter::open(const std::string& path, bool compress)
+{
+    close();
+
+    ofs.open(path, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+        return false;
+
+    header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version       = Records::VERSION;
+    header.record_size   = sizeof(GameRecord);
+    header.codec         = compress ? Records::CODEC_ZERO_RLE : Records::CODEC_NONE;
+    header.block_records = BLOCK_RECORDS;
+    header.n_records     = 0;
+
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    n_written = 0;
+    n_bytes   = sizeof(header);
+    failed    = false;
+    closing   = false;
+    io = std::thread([this]() { run(); });
+
+    return bool(ofs);
+}
+
+bool RecordWriter::close()
+{
+    if (!io.joinable())
+        return !failed;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closing = true;
+    }
+    cv.notify_one();
+    io.join();
+
+    // The count of records tells the readers that the file is complete.
+    header.n_records = n_written;
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.close();
+
+    failed |= !ofs;
+    return !failed;
+}
+
+// Only takes the lock for moving the block in, the producers never wait on the disk.
+void RecordWriter::submit(std::vector<GameRecord>&& block)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back(std::move(block));
+    }
+    cv.notify_one();
+}
+
+void RecordWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true)
+    {
+        cv.wait(lock, [this]() { return closing || !queue.empty(); });
+
+        if (queue.empty())
+            break;
+
+        auto block = std::move(queue.front());
+        queue.pop_front();
+
+        lock.unlock();
+        write_block(block);
+        lock.lock();
+    }
+}
+
+void RecordWriter::write_block(const std::vector<GameRecord>& block)
+{
+    const auto* data = reinterpret_cast<const uint8_t*>(block.data());
+    size_t size = block.size() * sizeof(GameRecord);
+
+    if (header.codec == Records::CODEC_NONE)
+    {
+        ofs.write(reinterpret_cast<const char*>(data), size);
+        n_bytes += size;
+    }
+    else
+    {
+        Records::compress(data, size, encoded);
+
+        Records::BlockHeader bh { uint32_t(block.size()), uint32_t(encoded.size()) };
+        ofs.write(reinterpret_cast<const char*>(&bh), sizeof(bh));
+        ofs.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+        n_bytes += sizeof(bh) + encoded.size();
+    }
+
+    failed |= !ofs;
+    n_written += block.size();
+}
+
+//********************************* Reading *******************************/
+
+RecordReader::~RecordReader()
+{
+    close();
+}
+
+bool RecordReader::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Records::Header))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);    // The mapping keeps the file alive.
+
+    if (p == MAP_FAILED)
+        return false;
+
+    const auto* header = static_cast<const Records::Header*>(p);
+    const auto* base   = static_cast<const uint8_t*>(p);
+    size_t body = st.st_size - sizeof(Records::Header);
+
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+              && header->version == Records::VERSION
+              && header->record_size == sizeof(GameRecord)
+              && header->codec <= Records::CODEC_ZERO_RLE;
+
+    // The records are counted from the file itself, in case the writer wasn't closed:
+    // the whole records, or the whole blocks.
+    size_t n = 0;
+    if (valid && header->codec == Records::CODEC_NONE)
+        n = body / sizeof(GameRecord);
+    else if (valid)
+    {
+        for (size_t off = sizeof(Records::Header); off + sizeof(Records::BlockHeader) <= (size_t)st.st_size;)
+        {
+            Records::BlockHeader bh;
+            std::memcpy(&bh, base + off, sizeof(bh));
+            off += sizeof(bh) + bh.stored_size;
+            if (off > (size_t)st.st_size)
+                break;
+            n += bh.n_records;
+        }
+    }
+
+    if (!valid)
+    {
+        munmap(p, st.st_size);
+        return false;
+    }
+
+    map       = p;
+    map_size  = st.st_size;
+    codec     = header->codec;
+    n_records = n;
+
+    rewind();
+    return true;
+}
+
+void RecordReader::close()
+{
+    if (map)
+        munmap(map, map_size);
+
+    map       = nullptr;
+    map_size  = 0;
+    n_records = 0;
+    cur = cur_end = nullptr;
+    block.clear();
+}
+
+void RecordReader::rewind()
+{
+    offset = sizeof(Records::Header);
+
+    if (map && codec == Records::CODEC_NONE)
+    {
+        cur     = reinterpret_cast<const GameRecord*>(static_cast<const uint8_t*>(map) + offset);
+        cur_end = cur + n_records;
+    }
+    else
+        cur = cur_end = nullptr;
+}
+
+const GameRecord* RecordReader::next()
+{
+    if (cur != cur_end)
+        return cur++;
+
+    if (!map || codec == Records::CODEC_NONE)
+        return nullptr;
+
+    // Decode the next block.
+    const auto* base = static_cast<const uint8_t*>(map);
+    Records::BlockHeader bh;
+
+    if (offset + sizeof(bh) > map_size)
+        return nullptr;
+    std::memcpy(&bh, base + offset, sizeof(bh));
+
+    if (offset + sizeof(bh) + bh.stored_size > map_size || bh.n_records == 0)
+        return nullptr;
+
+    block.resize(bh.n_records);
+    if (!Records::decompress(base + offset + sizeof(bh), bh.stored_size,
+                             reinterpret_cast<uint8_t*>(block.data()), block.size() * sizeof(GameRecord)))
+        return nullptr;
+
+    offset += sizeof(bh) + bh.stored_size;
+    cur     = block.data();
+    cur_end = cur + block.size();
+
+    return cur++;
+}
+
+}  // namespace mcts
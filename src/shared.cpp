@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "shared.h"
+
+namespace mcts {
+
+namespace {
+
+    constexpr char MAGIC[8] = { 'M', 'C', 'T', 'S', 'S', 'H', 'M', 'T' };
+
+    size_t segment_size(size_t n_entries)
+    {
+        return sizeof(SharedTable::Header) + n_entries * sizeof(SharedTable::Entry);
+    }
+
+} // namespace
+
+//******************************** Segment ******************************/
+
+SharedTable::~SharedTable()
+{
+    close();
+}
+
+bool SharedTable::open(const std::string& name, size_t n)
+{
+    close();
+
+    size_t rounded = 1;
+    while (rounded < n)
+        rounded <<= 1;
+
+    // Exactly one process creates the segment and initializes it, the others
+    // wait for it to be sized and then for the ready flag.
+    bool creator = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST)
+    {
+        creator = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (creator)
+    {
+        if (ftruncate(fd, segment_size(rounded)) < 0)
+        {
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        st.st_size = segment_size(rounded);
+    }
+    else
+    {
+        for (int i = 0; fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(Header); ++i)
+        {
+            if (i == 1000)
+            {
+                ::close(fd);
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void* p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+        return false;
+
+    auto* header = static_cast<Header*>(p);
+
+    if (creator)
+    {
+        // The new pages are zeroed, so only the keys need to be marked free.
+        auto* e = reinterpret_cast<Entry*>(header + 1);
+        for (size_t i = 0; i < rounded; ++i)
+            e[i].key.store(FREE, std::memory_order_relaxed);
+
+        std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version      = VERSION;
+        header->max_children = Agent::MAX_CHILDREN;
+        header->n_entries    = rounded;
+        header->ready.store(1, std::memory_order_release);
+    }
+    else
+    {
+        for (int i = 0; !header->ready.load(std::memory_order_acquire); ++i)
+        {
+            if (i == 1000)
+            {
+                munmap(p, st.st_size);
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+              && header->version == VERSION
+              && header->max_children == (uint32_t)Agent::MAX_CHILDREN
+              && segment_size(header->n_entries) == (size_t)st.st_size;
+
+    if (!valid)
+    {
+        munmap(p, st.st_size);
+        return false;
+    }
+
+    map       = p;
+    map_size  = st.st_size;
+    entries   = reinterpret_cast<Entry*>(header + 1);
+    n_entries = header->n_entries;
+
+    return true;
+}
+
+void SharedTable::close()
+{
+    if (map)
+        munmap(map, map_size);
+
+    map       = nullptr;
+    map_size  = 0;
+    entries   = nullptr;
+    n_entries = 0;
+}
+
+// The segment lives until it is unlinked, even when no process has it open.
+bool SharedTable::unlink(const std::string& name)
+{
+    return shm_unlink(name.c_str()) == 0;
+}
+
+size_t SharedTable::size() const
+{
+    size_t n = 0;
+    for (size_t i = 0; i < n_entries; ++i)
+        n += entries[i].key.load(std::memory_order_relaxed) != FREE;
+
+    return n;
+}
+
+//******************************** Entries ******************************/
+
+// The three least significant bits of a key are the status bits, so they are skipped.
+SharedTable::Entry* SharedTable::find(Key key, bool insert) const
+{
+    for (int i = 0; i < PROBES; ++i)
+    {
+        Entry& e = entries[((key >> 3) + i) & (n_entries - 1)];
+        Key k = e.key.load(std::memory_order_acquire);
+
+        if (k == key)
+            return &e;
+
+        if (k == FREE)
+        {
+            if (!insert)
+                return nullptr;
+            if (e.key.compare_exchange_strong(k, key, std::memory_order_acq_rel) || k == key)
+                return &e;
+        }
+    }
+    return nullptr;
+}
+
+SharedTable::Edge* SharedTable::find_edge(Entry& entry, Move move, bool insert)
+{
+    for (auto& edge : entry.edges)
+    {
+        int32_t m = edge.move.load(std::memory_order_acquire);
+
+        if (m == move)
+            return &edge;
+
+        if (m == MOVE_NONE)
+        {
+            if (!insert)
+                return nullptr;
+            if (edge.move.compare_exchange_strong(m, move, std::memory_order_acq_rel) || m == move)
+                return &edge;
+        }
+    }
+    return nullptr;
+}
+
+void SharedTable::add(Key key, Move move, int weight, Reward value, Reward sq_value)
+{
+    Entry* entry = find(key, true);
+    if (!entry)
+        return;
+
+    Edge* edge = find_edge(*entry, move, true);
+    if (!edge)
+        return;
+
+    edge->n_visits.fetch_add(weight, std::memory_order_relaxed);
+    edge->action_value.fetch_add(value, std::memory_order_relaxed);
+    edge->sq_action_value.fetch_add(sq_value, std::memory_order_relaxed);
+}
+
+bool SharedTable::load(Node& node) const
+{
+    Entry* entry = find(node.key, false);
+    if (!entry)
+        return false;
+
+    int total = 0;
+    for (int i = 0; i < node.n_children; ++i)
+    {
+        auto& c    = node.children[i];
+        Edge* edge = find_edge(*entry, c.move, false);
+        if (!edge)
+        {
+            total += c.n_visits;
+            continue;
+        }
+
+        // The virtual visits of this process' pending evaluations are on top.
+        c.n_visits         = edge->n_visits.load(std::memory_order_relaxed) + c.n_pending;
+        c.action_value     = edge->action_value.load(std::memory_order_relaxed);
+        c.sq_action_value  = edge->sq_action_value.load(std::memory_order_relaxed);
+        c.avg_action_value = c.n_visits > 0 ? c.action_value / c.n_visits : 0;
+        total += c.n_visits;
+    }
+
+    // The node is visited once more than its edges: the visit that expanded it.
+    node.n_visits = std::max(node.n_visits, total + 1);
+
+    return true;
+}
+
+} // namespace mcts
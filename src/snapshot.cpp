@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "snapshot.h"
+
+namespace mcts {
+
+namespace {
+
+    constexpr char MAGIC[8] = { 'M', 'C', 'T', 'S', 'S', 'N', 'A', 'P' };
+
+}
+
+//******************************** Conversions ***************************/
+
+void Snapshot::to_record(const Node& node, Record& rec)
+{
+    std::memset(&rec, 0, sizeof(Record));
+
+    rec.key        = node.key;
+    rec.n_visits   = node.n_visits;
+    rec.n_children = node.n_children;
+    rec.value_sum  = node.value_sum;
+    rec.n_updates  = node.n_updates;
+
+    // Only the children: the edges past them may never have been initialized.
+    for (int i=0; i<node.n_children; ++i)
+    {
+        const auto& a = node.children[i];
+        auto& e       = rec.children[i];
+
+        e.move             = a.move;
+        e.n_visits         = a.n_visits;
+        e.prior_value      = a.prior_value;
+        e.action_value     = a.action_value;
+        e.avg_action_value = a.avg_action_value;
+        e.sq_action_value  = a.sq_action_value;
+        e.decisive         = a.decisive;
+        e.policy           = a.policy;
+    }
+
+    if (node.n_children < Agent::MAX_CHILDREN)
+        rec.children[node.n_children].move = MOVE_END;
+}
+
+void Snapshot::to_node(const Record& rec, Node& node)
+{
+    node.key        = rec.key;
+    node.n_visits   = rec.n_visits;
+    node.n_children = rec.n_children;
+    node.n_expanded_children = rec.n_children;
+    node.value_sum  = rec.value_sum;
+    node.n_updates  = rec.n_updates;
+
+    for (int i=0; i<Agent::MAX_CHILDREN; ++i)
+    {
+        const auto& e = rec.children[i];
+        auto& a       = node.children[i];
+
+        a.move             = Move(e.move);
+        a.n_visits         = e.n_visits;
+        a.prior_value      = e.prior_value;
+        a.action_value     = e.action_value;
+        a.avg_action_value = e.avg_action_value;
+        a.sq_action_value  = e.sq_action_value;
+        a.decisive         = e.decisive;
+        a.n_pending        = 0;
+        a.policy           = e.policy;
+        a.child_key        = 0;
+        a.child            = nullptr;
+        a.child_epoch      = 0;
+    }
+}
+
+//*********************************** Writing *****************************/
+
+bool Snapshot::save(const std::string& path, const MCTSLookupTable& table, const BasicArena<State>& arena,
+                    const std::vector<Node>& direct)
+{
+    std::vector<Record> recs;
+    recs.reserve(table.size() + arena.size());
+
+    // Nodes created but never expanded carry no information, nor do the unused
+    // slots of the direct table.
+    auto add = [&recs](const Node& node) {
+        if (node.n_visits == 0)
+            return;
+        recs.emplace_back();
+        to_record(node, recs.back());
+    };
+
+    for (const auto& [key, node] : table)
+        add(node);
+
+    // A compacted tree is in the arena, not in the table.
+    for (const auto& node : arena.nodes)
+        add(node);
+
+    // So is the whole tree of the searches which use the direct table.
+    for (const auto& node : direct)
+        add(node);
+
+    std::sort(recs.begin(), recs.end(), [](const auto& a, const auto& b){
+            return a.key < b.key;
+        });
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version      = VERSION;
+    header.max_children = Agent::MAX_CHILDREN;
+    header.n_records    = recs.size();
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+        return false;
+
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    ofs.write(reinterpret_cast<const char*>(recs.data()), recs.size() * sizeof(Record));
+
+    return bool(ofs);
+}
+
+//*********************************** Reading *****************************/
+
+Snapshot::~Snapshot()
+{
+    close();
+}
+
+bool Snapshot::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Header))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);    // The mapping keeps the file alive.
+
+    if (p == MAP_FAILED)
+        return false;
+
+    const auto* header = static_cast<const Header*>(p);
+
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+              && header->version == VERSION
+              && header->max_children == (uint32_t)Agent::MAX_CHILDREN
+              && sizeof(Header) + header->n_records * sizeof(Record) == (size_t)st.st_size;
+
+    if (!valid)
+    {
+        munmap(p, st.st_size);
+        return false;
+    }
+
+    map       = p;
+    map_size  = st.st_size;
+    records   = reinterpret_cast<const Record*>(static_cast<const char*>(p) + sizeof(Header));
+    n_records = header->n_records;
+
+    return true;
+}
+
+void Snapshot::close()
+{
+    if (map)
+        munmap(map, map_size);
+
+    map       = nullptr;
+    map_size  = 0;
+    records   = nullptr;
+    n_records = 0;
+}
+
+const Snapshot::Record* Snapshot::find(Key key) const
+{
+    const Record* last = records + n_records;
+    const Record* it   = std::lower_bound(records, last, key, [](const Record& r, Key k){
+            return r.key < k;
+        });
+
+    return it != last && it->key == key ? it : nullptr;
+}
+
+} // namespace mcts
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "solver.h"
+
+namespace mcts {
+
+namespace Solver {
+
+namespace {
+
+    constexpr std::array<std::array<int, 3>, 8> LINES = { { { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 },
+        { 0, 3, 6 }, { 1, 4, 7 }, { 2, 5, 8 }, { 0, 4, 8 }, { 2, 4, 6 } } };
+
+    struct Decoded {
+        State::grid_t grid;
+        int  n_x = 0;
+        int  n_o = 0;
+    };
+
+    Decoded decode(int index)
+    {
+        Decoded d;
+        for (int c = 0; c < 9; ++c)
+        {
+            d.grid[c] = Token(index % 3);
+            index /= 3;
+            d.n_x += d.grid[c] == X;
+            d.n_o += d.grid[c] == O;
+        }
+        return d;
+    }
+
+    bool has_line(const State::grid_t& grid, Token t)
+    {
+        for (const auto& [a, b, c] : LINES)
+        {
+            if (grid[a] == t && grid[b] == t && grid[c] == t)
+                return true;
+        }
+        return false;
+    }
+
+    // Solve one position, assuming all positions with one more token are solved.
+    Value solve_one(int index, const std::vector<uint8_t>& values)
+    {
+        Decoded d = decode(index);
+
+        if (d.n_x != d.n_o && d.n_x != d.n_o + 1)
+            return VALUE_NONE;
+
+        bool x_line = has_line(d.grid, X);
+        bool o_line = has_line(d.grid, O);
+
+        // The game stops at the first line, which was made by the last player.
+        if ((x_line && (o_line || d.n_x == d.n_o)) || (o_line && d.n_x != d.n_o))
+            return VALUE_NONE;
+        if (x_line || o_line)
+            return VALUE_LOSS;
+        if (d.n_x + d.n_o == 9)
+            return VALUE_DRAW;
+
+        Token to_move = d.n_x == d.n_o ? X : O;
+        Value best = VALUE_LOSS;
+
+        for (int c = 0; c < 9; ++c)
+        {
+            if (d.grid[c] != TOK_EMPTY)
+                continue;
+
+            best = std::max(best, flip(Value(values[index + to_move * State::POW3[c]])));
+            if (best == VALUE_WIN)
+                break;
+        }
+        return best;
+    }
+
+} // namespace
+
+//*********************************** Solving ******************************/
+
+Table::~Table()
+{
+    if (map)
+        munmap(map, map_size);
+}
+
+void Table::solve(int n_threads)
+{
+    if (n_threads <= 0)
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Group the encodings by number of tokens: positions of a layer only
+    // depend on the next one, so a layer can be solved in parallel.
+    std::array<std::vector<int>, 10> layers;
+    for (int i = 0; i < N_POSITIONS; ++i)
+    {
+        Decoded d = decode(i);
+        layers[d.n_x + d.n_o].push_back(i);
+    }
+
+    // One byte per position while solving, so that threads never share a byte.
+    std::vector<uint8_t> values(N_POSITIONS, VALUE_NONE);
+
+    for (int k = 9; k >= 0; --k)
+    {
+        const auto& layer = layers[k];
+        std::vector<std::thread> workers;
+
+        for (int t = 0; t < n_threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                for (size_t j = t; j < layer.size(); j += n_threads)
+                    values[layer[j]] = solve_one(layer[j], values);
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+    }
+
+    storage.fill(0);
+    for (int i = 0; i < N_POSITIONS; ++i)
+        storage[i >> 2] |= values[i] << ((i & 3) << 1);
+
+    if (map)
+        munmap(map, map_size);
+    map  = nullptr;
+    bits = storage.data();
+}
+
+//******************************** Persistence ****************************/
+
+bool Table::save(const std::string& path) const
+{
+    if (!bits)
+        return false;
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char*>(bits), TABLE_BYTES);
+
+    return bool(ofs);
+}
+
+bool Table::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size != TABLE_BYTES)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, TABLE_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+        return false;
+
+    if (map)
+        munmap(map, map_size);
+
+    map      = p;
+    map_size = TABLE_BYTES;
+    bits     = static_cast<const uint8_t*>(p);
+
+    return true;
+}
+
+//*********************************** Queries ******************************/
+
+Reward Table::reward(const State& state, Move move) const
+{
+    int child = state.index_after(move);
+
+    return to_reward(flip(value(child)));
+}
+
+Move Table::best_move(State& state) const
+{
+    Move best = MOVE_NONE;
+    Reward best_r = -1;
+
+    for (auto move : state.valid_actions())
+    {
+        Reward r = reward(state, move);
+        if (r > best_r)
+        {
+            best_r = r;
+            best = move;
+        }
+    }
+    return best;
+}
+
+bool Table::is_perfect(State& state, Move move) const
+{
+    return reward(state, move) == to_reward(value(state));
+}
+
+} // namespace Solver
+
+} // namespace mcts
@@ -6,7 +6,6 @@
 #include <limits>
 #include <iterator>
 #include <numeric>
-#include <random>
 #include <string>
 #include <utility>
 #include "tictactoe.h"
@@ -51,12 +50,6 @@ Move State::cellTokenToMove(Cell c, Token t)
 // Can do the TT queries with the id-keys, and put the rest of the data in a StateData object (which is fetched).
 namespace Zobrist {
 
-    std::array<Key, 19> ndx_keys { 0 };     // First entry will be 0, for the Empty initial state
-
-    Key moveKey(Move move) {
-        return ndx_keys[move];
-    }
-
     Key tokenKey(Cell i, Token token) {
         //return ndx_keys[(1 + i) * (1 - ((token & 2) >> 1)) + ((token & 1) * 10)];
         return moveKey(State::cellTokenToMove(i, token));
@@ -66,9 +59,6 @@ namespace Zobrist {
         return tokenKey(i, X) ^ tokenKey(i, O);
     }
 
-    Key terminalKey = 1;
-    Key sideKey = 2;
-    Key drawKey = 4;
     /**
      * The second bit tells us the next player to play.
      * the first bit tells us if state is terminal,
@@ -88,32 +78,42 @@ namespace Zobrist {
 }  // namespace Zobrist
 
 
-// TODO Try with smaller types (32bit) since the state space is so small.
-void State::init()
-{
-     std::random_device rd;
-     std::uniform_int_distribution<unsigned long long> dis(
-         std::numeric_limits<std::uint64_t>::min(),
-         std::numeric_limits<std::uint64_t>::max()
-    );
-    for (int i=1; i<19; ++i)
-    {
-        Zobrist::ndx_keys[i] = ((dis(rd) >> 3) << 3);    // Least three significant bits are reserved.
-    }
-}
-
 State::State()
     : gamePly(1)
     , m_grid{}
 
 {
-    for (int i=0; i<9; ++i)
+    m_valid_actions.reserve(MAX_MOVES);
+
+    m_start.key = 0;
+    m_start.gamePly = 1;
+    m_start.previous = nullptr;
+    data = &m_start;
+}
+
+State::State(const State& other)
+    : data(&m_start)
+    , gamePly(other.gamePly)
+    , m_grid(other.m_grid)
+    , m_empty(other.m_empty)
+    , m_index(other.m_index)
+{
+    m_valid_actions.reserve(MAX_MOVES);
+
+    start_from(m_start, *other.data);
+}
+
+State& State::operator=(const State& other)
+{
+    if (this != &other)
     {
-        m_empty_cells.push_back(Cell(i));
+        gamePly = other.gamePly;
+        m_grid  = other.m_grid;
+        m_empty = other.m_empty;
+        m_index = other.m_index;
+        data = start_from(m_start, *other.data);
     }
-    data = new StateData();
-    data->key = 0;
-    data->gamePly = 1;
+    return *this;
 }
 
 // State::State(grid_t&& grid)
@@ -131,6 +131,49 @@ Key State::key() const
     return data->key;
 }
 
+Key State::key_after(Move m) const
+{
+    auto cell  = moveToCell(m);
+    auto token = moveToToken(m);
+
+    // Only the lines through the cell can be completed by the move.
+    bool win = false;
+    for (const auto& [a, b, c] : WIN_LINES)
+    {
+        if (a != cell && b != cell && c != cell)
+            continue;
+
+        win |= (a == cell || m_grid[a] == token)
+            && (b == cell || m_grid[b] == token)
+            && (c == cell || m_grid[c] == token);
+    }
+    bool full = gamePly >= 9;
+
+    Key key = data->key ^ Zobrist::moveKey(m) ^ Zobrist::sideKey;
+    key ^= status_bits(win, full);
+
+    return key;
+}
+
+int State::index() const
+{
+    return m_index;
+}
+
+int State::index_after(Move m) const
+{
+    return m_index + moveToToken(m) * POW3[moveToCell(m)];
+}
+
+int State::index(const grid_t& grid)
+{
+    int ndx = 0;
+    for (int c = 0; c < 9; ++c)
+        ndx += grid[c] * POW3[c];
+
+    return ndx;
+}
+
 Token State::next_player() const
 {
     return gamePly & 1 ? X : O;
@@ -144,8 +187,7 @@ bool State::is_full() const
 
 bool State::is_valid(Move move) const
 {
-    Cell cell = moveToCell(move);
-    return std::find(m_empty_cells.begin(), m_empty_cells.end(), cell) != m_empty_cells.end();
+    return m_empty >> moveToCell(move) & 1;
 }
 
 std::vector<Move>& State::valid_actions()
@@ -158,9 +200,10 @@ std::vector<Move>& State::valid_actions()
     }
 
     auto token = next_player();
-    for (auto c : m_empty_cells)
+    for (int c=0; c<9; ++c)
     {
-        m_valid_actions.push_back(cellTokenToMove(c, token));
+        if (m_empty >> c & 1)
+            m_valid_actions.push_back(cellTokenToMove(Cell(c), token));
     }
     return m_valid_actions;
 }
@@ -197,10 +240,12 @@ void State::apply_move(Move m, StateData& new_sd)
 
     // Make sure the move corresponds to an empty cell
     auto cell = moveToCell(m);
-    assert(m_empty_cells.remove(cell) == 1);
+    assert(m_empty >> cell & 1);
+    m_empty &= ~(1 << cell);
 
     // Place the new token in the cell
     m_grid[(int)cell] = moveToToken(m);
+    m_index += moveToToken(m) * POW3[cell];
     ++gamePly;
 
     // Update the key for the move
@@ -227,22 +272,38 @@ void State::undo_move(Move m)
     assert(m_grid[(int)cell] != TOK_EMPTY);
 
     // Remove the token from the grid.
+    m_index -= m_grid[(int)cell] * POW3[cell];
     m_grid[(int)cell] = TOK_EMPTY;
-    m_empty_cells.push_back(cell);
+    m_empty |= 1 << cell;
 
     // Revert the StateData.
     --gamePly;
     data = data->previous;
 }
 
+uint16_t State::stones(Token token) const
+{
+    uint16_t mask = 0;
+    for (int i=0; i<9; ++i)
+        mask |= (m_grid[i] == token) << i;
+
+    return mask;
+}
+
 const State::grid_t& State::grid() const
 {
     return m_grid;
 }
 
-const std::list<Cell>& State::empty_cells() const
+std::vector<Cell> State::empty_cells() const
 {
-    return m_empty_cells;
+    std::vector<Cell> cells;
+    for (int c=0; c<9; ++c)
+    {
+        if (m_empty >> c & 1)
+            cells.push_back(Cell(c));
+    }
+    return cells;
 }
 
 } // namespace mcts
@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include "trace.h"
+
+namespace mcts {
+
+namespace Trace {
+
+namespace {
+
+    constexpr char MAGIC[8] = { 'M', 'C', 'T', 'S', 'T', 'R', 'A', 'C' };
+
+    size_t round_up_pow2(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+            p <<= 1;
+        return p;
+    }
+
+}  // namespace
+
+uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Ring::Ring(size_t capacity)
+    : m_events(new Event[round_up_pow2(capacity)]())
+    , m_mask(round_up_pow2(capacity) - 1)
+{
+}
+
+std::vector<Event> Ring::events() const
+{
+    uint64_t head  = n_recorded();
+    uint64_t first = head > capacity() ? head - capacity() : 0;
+
+    std::vector<Event> out;
+    out.reserve(head - first);
+    for (uint64_t i = first; i < head; ++i)
+        out.push_back(m_events[i & m_mask]);
+
+    return out;
+}
+
+bool Ring::flush(const std::string& path) const
+{
+    uint64_t head = n_recorded();
+    auto evs = events();
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version    = VERSION;
+    header.event_size = sizeof(Event);
+    header.n_events   = evs.size();
+    header.n_dropped  = head - evs.size();
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+        return false;
+
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    ofs.write(reinterpret_cast<const char*>(evs.data()), evs.size() * sizeof(Event));
+
+    return bool(ofs);
+}
+
+Ring& ring()
+{
+    thread_local Ring r;
+    return r;
+}
+
+bool load(const std::string& path, std::vector<Event>& events, Header* header)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+        return false;
+
+    Header h;
+    if (!ifs.read(reinterpret_cast<char*>(&h), sizeof(Header)))
+        return false;
+
+    bool valid = std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+              && h.version == VERSION
+              && h.event_size == sizeof(Event);
+    if (!valid)
+        return false;
+
+    events.resize(h.n_events);
+    if (!ifs.read(reinterpret_cast<char*>(events.data()), h.n_events * sizeof(Event)))
+        return false;
+
+    if (header)
+        *header = h;
+    return true;
+}
+
+const char* type_name(EventType type)
+{
+    switch (type)
+    {
+        case EVENT_SEARCH:    return "search";
+        case EVENT_ITERATION: return "iteration";
+        case EVENT_SELECT:    return "select";
+        case EVENT_LEAF:      return "leaf";
+        case EVENT_ROLLOUT:   return "rollout";
+        case EVENT_BACKUP:    return "backup";
+        case EVENT_RESULT:    return "result";
+        default:              return "?";
+    }
+}
+
+}  // namespace Trace
+
+}  // namespace mcts
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include "cache.h"
+#include "tuner.h"
+
+namespace mcts {
+
+namespace Tuner {
+
+//****************************** Parameter space ************************/
+
+Params to_params(const Point& u)
+{
+    Params p;
+    p.exploration_cst   = EXP_C_MIN + u[0] * (EXP_C_MAX - EXP_C_MIN);
+    p.propagate_minimax = u[1] > 0.5;
+    p.n_rollouts        = 1 + (int)std::lround(u[2] * (ROLLOUTS_MAX - 1));
+
+    return p;
+}
+
+Point to_point(const Params& p)
+{
+    Point u;
+    u[0] = (p.exploration_cst - EXP_C_MIN) / (EXP_C_MAX - EXP_C_MIN);
+    u[1] = p.propagate_minimax ? 0.75 : 0.25;
+    u[2] = double(p.n_rollouts - 1) / (ROLLOUTS_MAX - 1);
+
+    for (auto& x : u)
+        x = std::clamp(x, 0.0, 1.0);
+
+    return u;
+}
+
+Params current()
+{
+    Params p;
+    p.exploration_cst   = Agent::exploration_cst;
+    p.propagate_minimax = Agent::propagate_minimax;
+    p.n_rollouts        = Agent::n_rollouts;
+
+    return p;
+}
+
+void apply(const Params& p)
+{
+    Agent::set_exp_c(p.exploration_cst);
+    Agent::set_backpropagate_minimax(p.propagate_minimax);
+    Agent::n_rollouts = std::max(1, p.n_rollouts);
+}
+
+//******************************** Self-play *****************************/
+
+Token play_game(Token side, std::mt19937& rng)
+{
+    // Nothing of the previous game, whose knobs were different, may leak into this one.
+    Agent::clear_table();
+    if (Agent::decision_cache)
+        Agent::decision_cache->clear();
+
+    State state;
+    std::array<StateData, 10> sd;
+    Agent agent(state);
+
+    for (int i = 0; !state.is_terminal(); ++i)
+    {
+        Move move;
+
+        if (side == TOK_EMPTY || state.next_player() == side)
+            move = agent.MCTSBestMove();
+        else
+        {
+            auto& moves = state.valid_actions();
+            move = moves[rng() % moves.size()];
+        }
+
+        state.apply_move(move, sd[i]);
+    }
+
+    return state.winner();
+}
+
+double evaluate(const Params& params, const Config& config, unsigned seed)
+{
+    apply(params);
+    Agent::debug_counters = false;
+    Agent::use_time = config.max_time > 0;
+    if (Agent::use_time)
+    {
+        Agent::set_max_iter(std::numeric_limits<int>::max());
+        Agent::set_search_time(config.max_time);
+    }
+    else
+        Agent::set_max_iter(config.max_iter);
+
+    std::mt19937 rng(seed);
+    int failures = 0;
+
+    for (int g = 0; g < config.games_per_eval; ++g)
+    {
+        switch (g % 3)
+        {
+        case 0: failures += play_game(X, rng) == O;              break;
+        case 1: failures += play_game(O, rng) == X;              break;
+        case 2: failures += play_game(TOK_EMPTY, rng) != TOK_EMPTY; break;
+        }
+    }
+
+    return double(failures) / config.games_per_eval;
+}
+
+//*********************************** SPSA *******************************/
+
+Params spsa(const Params& start, const Config& config)
+{
+    std::mt19937 rng(config.seed);
+    std::bernoulli_distribution coin(0.5);
+
+    Point theta = to_point(start);
+    Point best_theta = theta;
+    double best_loss = evaluate(start, config, rng());
+
+    for (int k = 0; k < config.n_steps && best_loss > 0; ++k)
+    {
+        double a_k = config.a / std::pow(k + 1 + config.A, config.alpha);
+        double c_k = config.c / std::pow(k + 1, config.gamma);
+
+        Point delta, plus, minus;
+        for (int i = 0; i < 3; ++i)
+        {
+            delta[i] = coin(rng) ? 1.0 : -1.0;
+            plus[i]  = std::clamp(theta[i] + c_k * delta[i], 0.0, 1.0);
+            minus[i] = std::clamp(theta[i] - c_k * delta[i], 0.0, 1.0);
+        }
+
+        // Common random numbers for both sides of the perturbation reduce the noise.
+        unsigned seed = rng();
+        double loss_plus  = evaluate(to_params(plus), config, seed);
+        double loss_minus = evaluate(to_params(minus), config, seed);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            double g = (loss_plus - loss_minus) / (2 * c_k * delta[i]);
+            theta[i] = std::clamp(theta[i] - a_k * g, 0.0, 1.0);
+        }
+
+        double loss = evaluate(to_params(theta), config, rng());
+        if (loss <= best_loss)
+        {
+            best_loss  = loss;
+            best_theta = theta;
+        }
+
+        if (config.verbose)
+        {
+            auto p = to_params(theta);
+            std::cerr << "SPSA step " << k
+                      << ": c=" << p.exploration_cst
+                      << " minimax=" << p.propagate_minimax
+                      << " rollouts=" << p.n_rollouts
+                      << " loss=" << loss
+                      << " (best " << best_loss << ")" << std::endl;
+        }
+    }
+
+    Params best = to_params(best_theta);
+    apply(best);
+
+    return best;
+}
+
+int cheapest_budget(const std::vector<int>& budgets, const Params& start, Params& best, Config config)
+{
+    Params params = start;
+
+    for (int budget : budgets)
+    {
+        if (config.max_time > 0)
+            config.max_time = budget;
+        else
+            config.max_iter = budget;
+
+        params = spsa(params, config);
+
+        // Confirm on fresh games before accepting the budget.
+        Config check = config;
+        check.games_per_eval *= 4;
+        if (evaluate(params, check, config.seed + budget) == 0)
+        {
+            best = params;
+            return budget;
+        }
+    }
+
+    best = params;
+    return -1;
+}
+
+} // namespace Tuner
+
+} // namespace mcts
@@ -0,0 +1,138 @@
+#include <array>
+#include <memory>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "alloc.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    using Alloc::PHASE_OTHER;
+    using Alloc::PHASE_EXPANSION;
+
+    TEST(AllocTest, CountsTheAllocationsOfTheThread)
+    {
+        ASSERT_TRUE(Alloc::counting());    // The test is linked with the hook.
+
+        auto before = Alloc::stats();
+        auto p = std::make_unique<std::array<char, 100>>();
+        auto diff = Alloc::stats() - before;
+
+        EXPECT_THAT(diff.total().allocs, Eq(1u));
+        EXPECT_THAT(diff.total().bytes, Eq(100u));
+        EXPECT_THAT(diff.phases[PHASE_OTHER].allocs, Eq(1u));
+    }
+
+    TEST(AllocTest, ScopesTagThePhases)
+    {
+        auto before = Alloc::stats();
+        {
+            Alloc::Scope phase(PHASE_EXPANSION);
+            auto p = std::make_unique<int[]>(8);
+        }
+        auto q = std::make_unique<int>(0);
+        auto diff = Alloc::stats() - before;
+
+        EXPECT_THAT(diff.phases[PHASE_EXPANSION].allocs, Eq(1u));
+        EXPECT_THAT(diff.phases[PHASE_EXPANSION].bytes, Eq(8 * sizeof(int)));
+        EXPECT_THAT(diff.phases[PHASE_OTHER].allocs, Eq(1u));
+    }
+
+    class SteadyStateTest : public ::testing::Test {
+    protected:
+        SteadyStateTest()
+        {
+            Agent::debug_counters = false;
+            Agent::clear_table();
+        }
+
+        ~SteadyStateTest()
+        {
+            Agent::direct_table = false;
+            Agent::clear_table();
+        }
+
+        // The allocations of a search, after a first one from the same position.
+        Alloc::Stats search_after_warm_up(State& state)
+        {
+            Agent agent(state);
+            agent.MCTSBestMove();
+
+            auto before = Alloc::stats();
+            agent.MCTSBestMove();
+            return Alloc::stats() - before;
+        }
+    };
+
+    // Nothing is left to allocate once the direct table is there.
+    TEST_F(SteadyStateTest, NoAllocationWithTheDirectTable)
+    {
+        Agent::direct_table = true;
+
+        State state;
+        auto diff = search_after_warm_up(state);
+
+        EXPECT_THAT(diff.total().allocs, Eq(0u)) << diff;
+    }
+
+    // The halving keeps its candidates on the stack.
+    TEST_F(SteadyStateTest, NoAllocationInTheHalving)
+    {
+        Agent::direct_table = true;
+        Agent::root_halving = true;
+
+        State state;
+        auto diff = search_after_warm_up(state);
+        Agent::root_halving = false;
+
+        EXPECT_THAT(diff.total().allocs, Eq(0u)) << diff;
+    }
+
+    // The compaction reuses its scratch space, once the arena it swaps with is allocated.
+    TEST_F(SteadyStateTest, NoAllocationInARepeatedCompaction)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        agent.compact();
+        agent.compact();
+
+        auto before = Alloc::stats();
+        agent.compact();
+        auto diff = Alloc::stats() - before;
+
+        EXPECT_THAT(diff.total().allocs, Eq(0u)) << diff;
+    }
+
+    // In the keyed table, the only allocations are the new nodes (the buckets
+    // being allocated up front).
+    TEST_F(SteadyStateTest, OnlyTheNewNodesAllocateInTheKeyedTable)
+    {
+        MCTS.reserve(10000);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        size_t n_nodes = MCTS.size();
+        auto before = Alloc::stats();
+        agent.MCTSBestMove();
+        auto diff = Alloc::stats() - before;
+
+        EXPECT_THAT(diff.total().allocs, Eq(MCTS.size() - n_nodes)) << diff;
+        EXPECT_THAT(diff.phases[PHASE_EXPANSION].allocs, Eq(0u));
+        EXPECT_THAT(diff.phases[Alloc::PHASE_SIMULATION].allocs, Eq(0u));
+        EXPECT_THAT(diff.phases[Alloc::PHASE_BACKPROPAGATION].allocs, Eq(0u));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
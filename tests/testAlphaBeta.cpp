@@ -0,0 +1,129 @@
+#include <array>
+#include <random>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "solver.h"
+
+namespace mcts {
+namespace {
+
+    class AlphaBetaTest : public ::testing::Test {
+    protected:
+        static void SetUpTestSuite()
+        {
+            table.solve(2);
+        }
+
+        AlphaBetaTest()
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+            Agent::set_max_iter(1000);
+        }
+
+        ~AlphaBetaTest()
+        {
+            Agent::ab_threshold = 0;
+            MCTS.clear();
+        }
+
+        // A random position after `n` plies which isn't over yet.
+        State random_position(int n, std::mt19937& rng)
+        {
+            while (true)
+            {
+                State state;
+                int i = 0;
+                for (; i < n && !state.is_terminal(); ++i)
+                {
+                    auto& moves = state.valid_actions();
+                    state.apply_move(moves[rng() % moves.size()], sd[i]);
+                }
+                if (!state.is_terminal())
+                    return state;
+            }
+        }
+
+        static int empty_cells(const State& state)
+        {
+            return State::MAX_GAME_PLY + 1 - state.gamePly;
+        }
+
+        static inline Solver::Table table;
+        std::array<StateData, 9> sd;
+    };
+
+    using namespace ::testing;
+
+    TEST_F(AlphaBetaTest, MatchesTheRetrogradeTable)
+    {
+        std::mt19937 rng(11);
+
+        for (int n = 4; n <= 7; ++n)
+        {
+            for (int k = 0; k < 25; ++k)
+            {
+                State state = random_position(n, rng);
+                Agent agent(state);
+
+                Reward expected = Solver::to_reward(table.value(state));
+                ASSERT_THAT(agent.alpha_beta(0, 1, empty_cells(state)), DoubleEq(expected))
+                    << "after " << n << " plies, position " << state.index();
+            }
+        }
+    }
+
+    // The children of a node expanded within ab_threshold have exact values.
+    TEST_F(AlphaBetaTest, ThresholdSolvesTheLeaves)
+    {
+        std::mt19937 rng(5);
+        State state = random_position(5, rng);
+        Agent::ab_threshold = empty_cells(state);
+
+        Agent agent(state);
+        const Node& root = MCTS[state.key()];
+
+        ASSERT_TRUE(root.best_known);
+        for (int i = 0; i < root.n_children; ++i)
+            EXPECT_THAT(root.children[i].prior_value, DoubleEq(table.reward(state, root.children[i].move)));
+
+        // And sorted by it.
+        for (int i = 1; i < root.n_children; ++i)
+            EXPECT_THAT(root.children[i - 1].prior_value, Ge(root.children[i].prior_value));
+    }
+
+    TEST_F(AlphaBetaTest, NodesAboveTheThresholdAreNotSolved)
+    {
+        std::mt19937 rng(5);
+        State state = random_position(3, rng);
+        Agent::ab_threshold = empty_cells(state) - 1;
+
+        Agent agent(state);
+        EXPECT_FALSE(MCTS[state.key()].best_known);
+    }
+
+    // Nothing is left to sample below a solved root.
+    TEST_F(AlphaBetaTest, SearchStopsOnASolvedRoot)
+    {
+        std::mt19937 rng(3);
+        State state = random_position(4, rng);
+        Agent::ab_threshold = empty_cells(state);
+
+        Agent agent(state);
+        Move move = agent.MCTSBestMove();
+
+        EXPECT_THAT(agent.info().iterations, Eq(0));
+        EXPECT_TRUE(table.is_perfect(state, move));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,131 @@
+#include <array>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "anytime.h"
+
+namespace mcts {
+namespace {
+
+    class AnytimeTest : public ::testing::Test {
+    protected:
+        void SetUp() override
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+            Agent::set_max_iter(std::numeric_limits<int>::max());
+        }
+
+        void TearDown() override
+        {
+            Agent::set_max_iter(1000);
+        }
+
+        State state {};
+    };
+
+    using namespace ::testing;
+    using namespace std::chrono_literals;
+
+    TEST_F(AnytimeTest, StopReturnsTheCurrentBestWithoutWaiting)
+    {
+        Agent agent(state);
+        SearchHandle<> handle(agent);
+        auto moves = state.valid_actions();    // The state belongs to the search thread until wait().
+
+        handle.start();
+        std::this_thread::sleep_for(20ms);
+        ASSERT_TRUE(handle.running());
+
+        auto start = std::chrono::steady_clock::now();
+        Move move  = handle.stop();
+        auto spent = std::chrono::steady_clock::now() - start;
+
+        EXPECT_THAT(moves, Contains(move));
+        EXPECT_THAT(spent, Lt(1ms));
+
+        Move final_move = handle.wait();
+        EXPECT_FALSE(handle.running());
+        EXPECT_THAT(state.valid_actions(), Contains(final_move));
+    }
+
+    // The search thread may not have looked at the new position yet: the move
+    // of the previous search, now occupied, mustn't be returned.
+    TEST_F(AnytimeTest, StopRightAfterStartIsLegal)
+    {
+        Agent::set_max_iter(200);
+
+        for (int game = 0; game < 20; ++game)
+        {
+            State position;
+            std::array<StateData, 9> sd;
+            Agent agent(position);
+            SearchHandle<> handle(agent);
+
+            for (int i = 0; !position.is_terminal(); ++i)
+            {
+                handle.start();
+                position.apply_move(handle.wait(), sd[i]);
+                if (position.is_terminal())
+                    break;
+
+                auto moves = position.valid_actions();
+                handle.start();
+                Move move = handle.stop();
+                handle.wait();
+
+                EXPECT_THAT(moves, Contains(move));
+            }
+        }
+    }
+
+    TEST_F(AnytimeTest, SubscribersGetPeriodicUpdates)
+    {
+        Agent agent(state);
+        SearchHandle<> handle(agent);
+        std::vector<SearchInfo> updates;
+
+        handle.subscribe([&](const SearchInfo& si) { updates.push_back(si); }, 5);
+        handle.start();
+        std::this_thread::sleep_for(50ms);
+        handle.stop();
+        handle.wait();
+
+        ASSERT_THAT(updates.size(), Ge(2u));
+        EXPECT_THAT(updates.back().iterations, Gt(updates.front().iterations));
+
+        const SearchInfo& last = updates.back();
+        EXPECT_THAT(last.root_visits.size(), Eq(9u));
+        ASSERT_THAT(last.pv, Not(IsEmpty()));
+        EXPECT_THAT(last.pv[0], Eq(last.best_move));
+    }
+
+    TEST_F(AnytimeTest, HandleCanSearchAgainAfterAStop)
+    {
+        Agent agent(state);
+        SearchHandle<> handle(agent);
+
+        handle.start();
+        handle.stop();
+        handle.wait();
+
+        Agent::set_max_iter(200);
+        handle.start();
+        Move move = handle.wait();
+
+        EXPECT_THAT(state.valid_actions(), Contains(move));
+        EXPECT_THAT(agent.info().iterations, Eq(200));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "evaluator.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    // Priors growing with the cell, so that their order is known, and even values.
+    // The batches are recorded (the agent waits for them, no lock is needed), and
+    // the threads they came from.
+    class StandInEvaluator : public Evaluator {
+    public:
+        void evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out) override
+        {
+            batches.push_back(leaves);
+            static thread_local bool seen = false;    // Ids can be reused, a new thread's locals can't.
+            threads += !std::exchange(seen, true);
+            out.resize(leaves.size());
+
+            for (size_t l = 0; l < leaves.size(); ++l)
+            {
+                double sum = 0;
+                for (int i = 0; i < leaves[l].n_moves; ++i)
+                    sum += prior_weight(leaves[l].moves[i]);
+                for (int i = 0; i < leaves[l].n_moves; ++i)
+                    out[l].priors[i] = prior_weight(leaves[l].moves[i]) / sum;
+                out[l].value = 0.5;
+            }
+        }
+
+        static double prior_weight(Move m)
+        {
+            return 1 + State::moveToCell(m);
+        }
+
+        std::vector<std::vector<Leaf>> batches;
+        int threads = 0;    // That called evaluate().
+    };
+
+    class BatchedTest : public ::testing::Test {
+    protected:
+        BatchedTest()
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+            Agent::evaluator = &evaluator;
+        }
+
+        ~BatchedTest()
+        {
+            Agent::evaluator = nullptr;
+            Agent::batch_size = 16;
+            Agent::set_max_iter(1000);
+            MCTS.clear();
+        }
+
+        // Without inserting the node if it is missing, as MCTS[key] would.
+        static const Node* find(Key key)
+        {
+            auto it = MCTS.find(key);
+            return it != MCTS.end() ? &it->second : nullptr;
+        }
+
+        static int edge_visits(const Node& node)
+        {
+            int n = 0;
+            for (int i = 0; i < node.n_children; ++i)
+                n += node.children[i].n_visits;
+            return n;
+        }
+
+        StandInEvaluator evaluator;
+    };
+
+    using namespace ::testing;
+
+    // Once the batches are applied no path is left pending, and the virtual
+    // visits were the real ones: each iteration is one visit of a root edge.
+    TEST_F(BatchedTest, VirtualVisitsAreSettled)
+    {
+        Agent::batch_size = 8;
+        Agent::set_max_iter(400);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        ASSERT_THAT(evaluator.batches, Not(IsEmpty()));
+        for (const auto& [key, node] : MCTS)
+            EXPECT_THAT(node.n_pending, Eq(0));
+
+        const Node* root = find(state.key());
+        ASSERT_THAT(root, NotNull());
+        EXPECT_THAT(edge_visits(*root), Eq(agent.info().iterations));
+        EXPECT_THAT(agent.info().iterations, Eq(400));
+
+        // Below the root every descent through a node took one of its edges.
+        for (int i = 0; i < root->n_children; ++i)
+        {
+            const ActionNode& edge = root->children[i];
+            if (edge.n_visits > 1 && edge.child_key)
+            {
+                const Node* child = find(edge.child_key);
+                ASSERT_THAT(child, NotNull());
+                EXPECT_THAT(edge_visits(*child), Eq(edge.n_visits - 1));
+            }
+        }
+    }
+
+    // A fresh root is a pending leaf itself: the next descent meets it, and it is
+    // sent alone. Then the nine descents go to the nine children, and the tenth
+    // would meet one of them: the batch is sent with the nine.
+    TEST_F(BatchedTest, CollisionEndsTheBatch)
+    {
+        Agent::batch_size = 16;
+        Agent::set_max_iter(9);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        ASSERT_THAT(evaluator.batches.size(), Eq(2u));
+        ASSERT_THAT(evaluator.batches[0].size(), Eq(1u));
+        EXPECT_THAT(evaluator.batches[0][0].key, Eq(state.key()));
+
+        const auto& batch = evaluator.batches[1];
+        ASSERT_THAT(batch.size(), Eq(9u));
+
+        std::set<Key> keys;
+        for (const Leaf& leaf : batch)
+            keys.insert(leaf.key);
+        EXPECT_THAT(keys.size(), Eq(9u));
+
+        const Node* root = find(state.key());
+        ASSERT_THAT(root, NotNull());
+        EXPECT_THAT(edge_visits(*root), Eq(9));
+        EXPECT_THAT(root->n_pending, Eq(0));
+
+        Agent::set_max_iter(40);
+        evaluator.batches.clear();
+        agent.MCTSBestMove();
+
+        // Each batch stops at the first collision, none of its leaves repeats.
+        for (const auto& b : evaluator.batches)
+        {
+            std::set<Key> distinct;
+            for (const Leaf& leaf : b)
+                distinct.insert(leaf.key);
+            EXPECT_THAT(distinct.size(), Eq(b.size()));
+        }
+        root = find(state.key());
+        ASSERT_THAT(root, NotNull());
+        EXPECT_THAT(edge_visits(*root), Eq(9 + 40));
+    }
+
+    // The leaves, the root first, are expanded with the evaluator's priors, highest
+    // first, and their edges know the keys of their children.
+    TEST_F(BatchedTest, PriorsComeFromTheEvaluator)
+    {
+        Agent::batch_size = 4;
+        Agent::set_max_iter(60);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        const Node* root = find(state.key());
+        ASSERT_THAT(root, NotNull());
+        ASSERT_THAT(root->n_children, Eq(9));
+        for (int i = 0; i < root->n_children; ++i)
+        {
+            const ActionNode& edge = root->children[i];
+            EXPECT_THAT(edge.policy, DoubleNear(StandInEvaluator::prior_weight(edge.move) / 45, 1e-12));
+            EXPECT_THAT(edge.child_key, Eq(state.key_after(edge.move)));
+        }
+
+        int n_checked = 0;
+
+        for (int i = 0; i < root->n_children; ++i)
+        {
+            const ActionNode& edge = root->children[i];
+            if (edge.n_visits == 0 || !edge.child_key)
+                continue;
+
+            const Node* found = find(edge.child_key);
+            ASSERT_THAT(found, NotNull());
+            const Node& child = *found;
+            ASSERT_THAT(child.n_children, Eq(8));
+
+            double sum = 0;
+            for (int j = 0; j < child.n_children; ++j)
+                sum += StandInEvaluator::prior_weight(child.children[j].move);
+
+            State next = state;
+            StateData sd;
+            next.apply_move(edge.move, sd);
+
+            for (int j = 0; j < child.n_children; ++j)
+            {
+                const ActionNode& a = child.children[j];
+                EXPECT_THAT(a.policy, DoubleNear(StandInEvaluator::prior_weight(a.move) / sum, 1e-12));
+                EXPECT_THAT(a.child_key, Eq(next.key_after(a.move)));
+                if (j > 0)
+                {
+                    EXPECT_THAT(child.children[j - 1].policy, Gt(a.policy));
+                }
+            }
+            ++n_checked;
+        }
+        EXPECT_THAT(n_checked, Eq(root->n_children));
+    }
+
+    // The evaluator's thread is started once, for all the searches of the agent.
+    TEST_F(BatchedTest, EvaluatorThreadOutlivesTheSearches)
+    {
+        Agent::set_max_iter(40);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        agent.MCTSBestMove();
+
+        EXPECT_THAT(evaluator.batches.size(), Gt(1u));
+        EXPECT_THAT(evaluator.threads, Eq(1));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
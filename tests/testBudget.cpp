@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <array>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    class BudgetTest : public ::testing::Test {
+    protected:
+        BudgetTest()
+        {
+            Agent::clear_table();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+        }
+
+        ~BudgetTest()
+        {
+            Agent::max_bytes = 0;
+            Agent::direct_table = false;
+            Agent::set_max_iter(1000);
+            Agent::clear_table();
+        }
+
+        std::array<StateData, 10> sd;
+    };
+
+    using namespace ::testing;
+
+    // Measured during the searches too, from the updates.
+    TEST_F(BudgetTest, TableStaysWithinTheBudget)
+    {
+        Agent::max_bytes = 256 * 1024;
+        Agent::set_max_iter(20000);
+
+        State state;
+        Agent agent(state);
+        size_t peak = 0;
+        int evictions = 0;
+        agent.set_update([&](const SearchInfo&) { peak = std::max(peak, Agent::table_bytes()); }, 1);
+
+        for (int i = 0; i < 4 && !state.is_terminal(); ++i)
+        {
+            Move move = agent.MCTSBestMove();
+            peak = std::max(peak, Agent::table_bytes());
+            evictions += agent.evictions();
+            state.apply_move(move, sd[i]);
+        }
+
+        EXPECT_THAT(evictions, Gt(0));
+        EXPECT_THAT(peak, Le(Agent::max_bytes));
+        EXPECT_THAT(MCTS.size(), Le(Agent::max_nodes()));
+    }
+
+    // The buckets and the eviction's scratch space are allocated before the nodes.
+    TEST_F(BudgetTest, FixedCostsAreCounted)
+    {
+        Agent::max_bytes = 128 * 1024;
+        Agent::set_max_iter(1);
+
+        State state;
+        Agent agent(state);
+        size_t n_nodes = MCTS.size();
+        size_t bytes = Agent::table_bytes();
+
+        EXPECT_THAT(MCTS.bucket_count(), Ge(Agent::max_nodes()));
+        EXPECT_THAT(bytes, Gt(MCTS.bucket_count() * sizeof(void*) + n_nodes * sizeof(Node)));
+        EXPECT_THAT(bytes, Le(Agent::max_bytes));
+    }
+
+    // A direct table larger than the budget isn't allocated, the keyed table is used.
+    TEST_F(BudgetTest, DirectTableMustFitTheBudget)
+    {
+        Agent::direct_table = true;
+        Agent::max_bytes = 64 * 1024;
+        ASSERT_THAT(State::INDEX_SIZE * sizeof(Node), Gt(Agent::max_bytes));
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        EXPECT_FALSE(Agent::uses_direct_table());
+        EXPECT_TRUE(direct_nodes<State>.empty());
+        EXPECT_THAT(Agent::table_bytes(), Le(Agent::max_bytes));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
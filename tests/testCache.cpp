@@ -0,0 +1,257 @@
+#include <array>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "cache.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    using Decision = DecisionCache::Decision;
+
+    class DecisionCacheTest : public ::testing::Test {
+    protected:
+        State play(std::vector<int> cells, int offset = 0)
+        {
+            State state;
+            for (size_t i = 0; i < cells.size(); ++i)
+                state.apply_move(State::cellTokenToMove(Cell(cells[i]), state.next_player()), sd[offset + i]);
+            return state;
+        }
+
+        static Decision decision(int cell, Token token)
+        {
+            Decision d;
+            d.move = State::cellTokenToMove(Cell(cell), token);
+            d.n_children = 1;
+            d.visits[0] = { d.move, 10 };
+            return d;
+        }
+
+        std::array<StateData, 20> sd;
+    };
+
+    // The 8 images of a position without symmetries are distinct, and have the same canonical form.
+    TEST_F(DecisionCacheTest, ImagesHaveTheSameCanonicalForm)
+    {
+        State state = play({ 0, 1, 5 });
+        auto [index, sym] = DecisionCache::canonical(state);
+
+        std::set<int> images;
+        for (int s = 0; s < DecisionCache::SYMMETRIES; ++s)
+        {
+            State image;
+            std::array<StateData, 3> isd;
+            int i = 0;
+            for (int cell : { 0, 1, 5 })
+            {
+                Move m = DecisionCache::transform(State::cellTokenToMove(Cell(cell), image.next_player()), s);
+                image.apply_move(m, isd[i++]);
+            }
+
+            images.insert(image.index());
+            EXPECT_THAT(DecisionCache::canonical(image).first, Eq(index));
+        }
+        EXPECT_THAT(images.size(), Eq(8u));
+        EXPECT_THAT(*images.begin(), Eq(index));
+    }
+
+    TEST_F(DecisionCacheTest, SymmetricPositionsShareTheirDecision)
+    {
+        DecisionCache cache(16);
+
+        // A quarter turn clockwise takes the cells 0, 1 and 2 to 2, 5 and 8.
+        State a = play({ 0, 1 });
+        State b = play({ 2, 5 }, 2);
+
+        cache.insert(a, 100, decision(2, X));
+        auto hit = cache.find(b, 100);
+
+        ASSERT_TRUE(hit.has_value());
+        EXPECT_THAT(hit->move, Eq(State::cellTokenToMove(Cell(8), X)));
+        EXPECT_THAT(hit->visits[0].first, Eq(hit->move));
+        EXPECT_THAT(cache.size(), Eq(1u));
+    }
+
+    TEST_F(DecisionCacheTest, BudgetIsPartOfTheKey)
+    {
+        DecisionCache cache(16);
+        State state = play({ 4 });
+
+        cache.insert(state, 100, decision(0, O));
+        EXPECT_FALSE(cache.find(state, 200).has_value());
+        EXPECT_TRUE(cache.find(state, 100).has_value());
+        EXPECT_THAT(cache.hits(), Eq(1u));
+        EXPECT_THAT(cache.misses(), Eq(1u));
+    }
+
+    TEST_F(DecisionCacheTest, LeastRecentlyUsedIsEvicted)
+    {
+        DecisionCache cache(2, 1);
+        State a = play({ 4 }), b = play({ 0 }, 1), c = play({ 1 }, 2);
+
+        cache.insert(a, 1, decision(0, O));
+        cache.insert(b, 1, decision(4, O));
+        ASSERT_TRUE(cache.find(a, 1).has_value());    // b is now the least recently used.
+
+        cache.insert(c, 1, decision(4, O));
+        EXPECT_TRUE(cache.find(a, 1).has_value());
+        EXPECT_FALSE(cache.find(b, 1).has_value());
+        EXPECT_TRUE(cache.find(c, 1).has_value());
+        EXPECT_THAT(cache.size(), Eq(2u));
+    }
+
+    TEST_F(DecisionCacheTest, ConcurrentRequests)
+    {
+        DecisionCache cache(64, 4);
+        std::vector<std::thread> threads;
+
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&cache, t]() {
+                std::mt19937 rng(t);
+                std::array<StateData, 9> tsd;
+
+                for (int i = 0; i < 2000; ++i)
+                {
+                    State state;
+                    int n = rng() % 4;
+                    for (int j = 0; j < n; ++j)
+                    {
+                        auto& moves = state.valid_actions();
+                        state.apply_move(moves[rng() % moves.size()], tsd[j]);
+                    }
+
+                    auto& moves = state.valid_actions();
+                    if (auto hit = cache.find(state, 1))
+                        ASSERT_TRUE(state.is_valid(hit->move));
+                    else
+                        cache.insert(state, 1, decision(State::moveToCell(moves[0]), state.next_player()));
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+
+        EXPECT_THAT(cache.size(), Le(cache.capacity()));
+        EXPECT_THAT(cache.hits() + cache.misses(), Eq(8000u));
+    }
+
+    // The second search of a position, or of one of its images, is the first one's.
+    TEST_F(DecisionCacheTest, AgentAnswersFromTheCache)
+    {
+        DecisionCache cache(16);
+        Agent::debug_counters = false;
+        Agent::decision_cache = &cache;
+        MCTS.clear();
+
+        State a = play({ 0, 1 });
+        Agent agent_a(a);
+        Move move = agent_a.MCTSBestMove();
+        ASSERT_THAT(cache.size(), Eq(1u));
+
+        size_t n_nodes = MCTS.size();
+        EXPECT_THAT(agent_a.MCTSBestMove(), Eq(move));
+
+        State b = play({ 2, 5 }, 2);
+        Agent agent_b(b);
+        EXPECT_THAT(agent_b.MCTSBestMove(), Eq(DecisionCache::transform(move, 1)));
+
+        EXPECT_THAT(cache.hits(), Eq(2u));
+        EXPECT_THAT(MCTS.size(), Le(n_nodes + 1));    // Only agent_b's root.
+
+        Agent::decision_cache = nullptr;
+        MCTS.clear();
+    }
+
+    // The searches of other policies, or with other knobs, have their own decisions.
+    TEST_F(DecisionCacheTest, ConfigurationIsPartOfTheKey)
+    {
+        DecisionCache cache(16, 1);
+        Agent::debug_counters = false;
+        Agent::decision_cache = &cache;
+        Agent::set_max_iter(200);
+        MCTS.clear();
+
+        State state = play({ 4 });
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        BasicAgent<State, Policy::PUCT, Policy::BestValue> puct(state);
+        puct.MCTSBestMove();
+        EXPECT_THAT(cache.size(), Eq(2u));
+
+        double exploration = Agent::exploration_cst;
+        Agent::exploration_cst = 2 * exploration;
+        agent.MCTSBestMove();
+        EXPECT_THAT(cache.size(), Eq(3u));
+        EXPECT_THAT(cache.hits(), Eq(0u));
+
+        Agent::exploration_cst = exploration;
+        agent.MCTSBestMove();
+        EXPECT_THAT(cache.hits(), Eq(1u));
+
+        Agent::decision_cache = nullptr;
+        Agent::set_max_iter(1000);
+        MCTS.clear();
+    }
+
+    // An answer from the cache reports the search it comes from, not the agent's previous one.
+    TEST_F(DecisionCacheTest, HitReportsTheCachedSearch)
+    {
+        DecisionCache cache(16, 1);
+        Agent::debug_counters = false;
+        Agent::decision_cache = &cache;
+        Agent::set_max_iter(300);
+        MCTS.clear();
+
+        State a = play({ 0, 1 });
+        Agent agent_a(a);
+        Move move = agent_a.MCTSBestMove();
+        SearchInfo searched = agent_a.info();
+
+        State b = play({ 2, 5 }, 2);
+        Agent agent_b(b);
+        Agent::set_max_iter(50);
+        agent_b.MCTSBestMove();    // Another budget, another entry, and counters for the hit to reset.
+        Agent::set_max_iter(300);
+
+        ASSERT_THAT(agent_b.MCTSBestMove(), Eq(DecisionCache::transform(move, 1)));
+        ASSERT_THAT(cache.hits(), Eq(1u));
+
+        SearchInfo hit = agent_b.info();
+        EXPECT_THAT(hit.best_move, Eq(DecisionCache::transform(move, 1)));
+        EXPECT_THAT(hit.iterations, Eq(searched.iterations));
+        EXPECT_THAT(hit.pv, ElementsAre(hit.best_move));
+        ASSERT_THAT(hit.root_visits.size(), Eq(searched.root_visits.size()));
+        for (size_t i = 0; i < hit.root_visits.size(); ++i)
+        {
+            EXPECT_THAT(hit.root_visits[i].first, Eq(DecisionCache::transform(searched.root_visits[i].first, 1)));
+            EXPECT_THAT(hit.root_visits[i].second, Eq(searched.root_visits[i].second));
+        }
+        EXPECT_THAT(agent_b.evictions(), Eq(0));
+
+        // The next search reports its own.
+        Agent::decision_cache = nullptr;
+        agent_b.MCTSBestMove();
+        EXPECT_THAT(agent_b.info().iterations, Eq(300));
+        EXPECT_THAT(agent_b.info().root_visits.size(), Eq(7u));
+
+        Agent::set_max_iter(1000);
+        MCTS.clear();
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
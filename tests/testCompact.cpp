@@ -0,0 +1,186 @@
+#include <array>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "solver.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    class CompactTest : public ::testing::Test {
+    protected:
+        CompactTest()
+        {
+            Agent::debug_counters = false;
+            Agent::clear_table();
+        }
+
+        ~CompactTest()
+        {
+            Agent::compact_tree = false;
+            Agent::compact_max_nodes = 0;
+            Agent::clear_table();
+        }
+
+        static size_t total_visits()
+        {
+            size_t n = 0;
+            for (const auto& [key, node] : MCTS)
+                n += node.n_visits;
+            for (const auto& node : game_arena<State>.nodes)
+                n += node.n_visits;
+            return n;
+        }
+
+        std::array<StateData, 9> sd;
+    };
+
+    TEST_F(CompactTest, TreeIsLaidOutDepthFirst)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        size_t n_nodes = MCTS.size();
+        size_t visits  = total_visits();
+
+        ASSERT_THAT(agent.compact(), Gt(1u));
+        const auto& arena = game_arena<State>.nodes;
+
+        // Nothing is lost, and no node is in both places.
+        EXPECT_THAT(MCTS.size() + arena.size(), Eq(n_nodes));
+        EXPECT_THAT(total_visits(), Eq(visits));
+        for (const auto& node : arena)
+            EXPECT_THAT(MCTS.count(node.key), Eq(0u));
+
+        // The root first, then its most visited child (the first one among equals)
+        // and that one's subtree.
+        EXPECT_THAT(arena[0].key, Eq(state.key()));
+        int most = 0;
+        for (int i = 1; i < arena[0].n_children; ++i)
+            if (arena[0].children[i].n_visits > arena[0].children[most].n_visits)
+                most = i;
+        EXPECT_THAT(arena[0].children[most].child, Eq(&arena[1]));
+
+        // The edges inside the arena point to their node.
+        for (const auto& node : arena)
+        {
+            for (int i = 0; i < node.n_children; ++i)
+            {
+                const auto* child = node.children[i].child;
+                if (child && node.children[i].child_epoch == Agent::table_epoch)
+                {
+                    EXPECT_TRUE(game_arena<State>.contains(child));
+                    EXPECT_THAT(child->key, Eq(node.children[i].child_key));
+                }
+            }
+        }
+    }
+
+    // Within a budget, the most visited nodes go to the arena, the others stay in the table.
+    TEST_F(CompactTest, BudgetKeepsTheMostVisitedNodes)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        size_t n_nodes = MCTS.size();
+        Agent::compact_max_nodes = 10;
+
+        ASSERT_THAT(agent.compact(), Eq(10u));
+        EXPECT_THAT(MCTS.size(), Eq(n_nodes - 10));
+
+        int least_in_arena = game_arena<State>.nodes[0].n_visits;
+        for (const auto& node : game_arena<State>.nodes)
+            least_in_arena = std::min(least_in_arena, node.n_visits);
+        EXPECT_THAT(least_in_arena, Gt(1));
+
+        // A second compaction without a budget takes them all back.
+        Agent::compact_max_nodes = 0;
+        agent.compact();
+        EXPECT_THAT(MCTS.size() + game_arena<State>.size(), Eq(n_nodes));
+    }
+
+    // The search's root moves to the arena, info() reports it from there.
+    TEST_F(CompactTest, InfoAfterCompaction)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        SearchInfo before = agent.info();
+
+        ASSERT_THAT(agent.compact(), Gt(1u));
+        SearchInfo after = agent.info();
+
+        EXPECT_THAT(after.root_visits, Eq(before.root_visits));
+        EXPECT_THAT(after.pv, Eq(before.pv));
+        EXPECT_THAT(after.iterations, Eq(before.iterations));
+    }
+
+    // The search's clock isn't spent on the compaction, the callers do it between the moves.
+    TEST_F(CompactTest, SearchDoesntCompact)
+    {
+        Agent::compact_tree = true;
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        agent.MCTSBestMove();
+
+        EXPECT_THAT(game_arena<State>.size(), Eq(0u));
+    }
+
+    // Compacting the same tree again lays it out the same way, and once both
+    // arenas (the live one and the scratch one) are allocated, in the same memory.
+    TEST_F(CompactTest, CompactionIsRepeatable)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        size_t n_arena = agent.compact();
+        ASSERT_THAT(agent.compact(), Eq(n_arena));
+        size_t bytes   = Agent::table_bytes();
+        Key first_key  = game_arena<State>.nodes[1].key;
+
+        EXPECT_THAT(agent.compact(), Eq(n_arena));
+        EXPECT_THAT(Agent::table_bytes(), Eq(bytes));
+        EXPECT_THAT(game_arena<State>.nodes[1].key, Eq(first_key));
+        for (const auto& node : game_arena<State>.nodes)
+            EXPECT_THAT(node.compact_mark, Eq(0u));
+    }
+
+    // A game where the tree is compacted before each move, the agent reusing it.
+    TEST_F(CompactTest, SearchesReuseTheCompactedTree)
+    {
+        Solver::Table table;
+        table.solve();
+
+        Agent::set_max_iter(2000);
+
+        State state;
+        Agent agent(state);
+        for (int i = 0; !state.is_terminal(); ++i)
+        {
+            agent.compact();
+            Move move = agent.MCTSBestMove();
+            EXPECT_TRUE(table.is_perfect(state, move)) << "At ply " << i;
+            EXPECT_THAT(game_arena<State>.find(state.key()), Eq(&game_arena<State>.nodes[0]));
+
+            state.apply_move(move, sd[i]);
+        }
+        EXPECT_TRUE(state.is_draw());
+
+        Agent::set_max_iter(1000);
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
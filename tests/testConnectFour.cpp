@@ -0,0 +1,189 @@
+#include <array>
+#include <random>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "connectfour.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    class ConnectFourTest : public ::testing::Test {
+    protected:
+        // Plays the columns, numbered from 1 as in the moves.
+        void play(const std::string& columns)
+        {
+            for (char c : columns)
+            {
+                Move move = Move(c - '0');
+                ASSERT_TRUE(state.is_valid(move));
+                state.apply_move(move, sd[n_moves++]);
+            }
+        }
+
+        ConnectFour state;
+        std::array<StateData, 43> sd;
+        int n_moves = 0;
+    };
+
+    using namespace ::testing;
+
+    TEST_F(ConnectFourTest, EmptyBoard)
+    {
+        EXPECT_THAT(state.key(), Eq(0u));
+        EXPECT_FALSE(state.is_terminal());
+        EXPECT_THAT(state.next_player(), Eq(X));
+        EXPECT_THAT(state.valid_actions(), UnorderedElementsAre(1, 2, 3, 4, 5, 6, 7));
+    }
+
+    TEST_F(ConnectFourTest, StonesStack)
+    {
+        play("443");
+        EXPECT_THAT(state.at(3, 0), Eq(X));
+        EXPECT_THAT(state.at(3, 1), Eq(O));
+        EXPECT_THAT(state.at(2, 0), Eq(X));
+        EXPECT_THAT(state.at(2, 1), Eq(TOK_EMPTY));
+        EXPECT_THAT(state.next_player(), Eq(O));
+    }
+
+    TEST_F(ConnectFourTest, FullColumnIsNotValid)
+    {
+        play("111111");
+        EXPECT_FALSE(state.is_valid(Move(1)));
+        EXPECT_THAT(state.valid_actions(), Not(Contains(Move(1))));
+    }
+
+    TEST_F(ConnectFourTest, FourInARowWins)
+    {
+        for (std::string game : { "1212121",        // Vertical
+                                  "1122334",        // Horizontal
+                                  "12233434544",    // Diagonal
+                                  "76655454344" })  // Anti-diagonal
+        {
+            state = ConnectFour();
+            n_moves = 0;
+            play(game);
+
+            EXPECT_TRUE(state.is_terminal()) << game;
+            EXPECT_THAT(state.winner(), Eq(X)) << game;
+            EXPECT_TRUE(ConnectFour::terminal(*state.data));
+            EXPECT_THAT(ConnectFour::terminal_value(*state.data), DoubleEq(1));
+            EXPECT_THAT(state.valid_actions(), IsEmpty());
+        }
+    }
+
+    // The sentinel row keeps the lines from wrapping around to the next column:
+    // the two X on top of the first column and at the bottom of the second don't
+    // make a four.
+    TEST_F(ConnectFourTest, NoWinAcrossColumns)
+    {
+        play("212111171");
+        EXPECT_FALSE(state.is_terminal());
+        EXPECT_THAT(state.winner(), Eq(TOK_EMPTY));
+    }
+
+    TEST_F(ConnectFourTest, FullBoardIsADraw)
+    {
+        play("656173566152215676422337377473141445425321");
+        EXPECT_TRUE(state.is_terminal());
+        EXPECT_TRUE(state.is_draw());
+        EXPECT_THAT(ConnectFour::terminal_value(*state.data), DoubleEq(0.5));
+    }
+
+    TEST_F(ConnectFourTest, TranspositionsHaveTheSameKey)
+    {
+        play("4352");
+        Key key = state.key();
+
+        ConnectFour other;
+        std::array<StateData, 4> osd;
+        int i = 0;
+        for (int col : { 5, 2, 4, 3 })
+            other.apply_move(Move(col), osd[i++]);
+
+        EXPECT_THAT(other.key(), Eq(key));
+    }
+
+    // Random games, checking key_after against apply_move and that undo_move
+    // restores the keys.
+    TEST_F(ConnectFourTest, KeysAreIncremental)
+    {
+        std::mt19937 rng(7);
+
+        for (int g = 0; g < 200; ++g)
+        {
+            ConnectFour game;
+            std::array<Key, 43> keys;
+            std::array<Move, 43> moves;
+            int n = 0;
+
+            while (!game.is_terminal())
+            {
+                keys[n] = game.key();
+                auto& actions = game.valid_actions();
+                Move move = actions[rng() % actions.size()];
+                Key after = game.key_after(move);
+
+                moves[n] = move;
+                game.apply_move(move, sd[n]);
+                ASSERT_THAT(game.key(), Eq(after));
+                ++n;
+            }
+
+            while (n > 0)
+            {
+                game.undo_move(moves[--n]);
+                ASSERT_THAT(game.key(), Eq(keys[n]));
+            }
+            EXPECT_THAT(game.board(X) | game.board(O), Eq(0u));
+        }
+    }
+
+    TEST_F(ConnectFourTest, CopyStartsFromThePosition)
+    {
+        play("4433");
+        ConnectFour copy = state;
+        EXPECT_THAT(copy.key(), Eq(state.key()));
+        EXPECT_THAT(copy.data, Ne(state.data));
+
+        StateData csd;
+        copy.apply_move(Move(2), csd);
+        play("2");
+        EXPECT_THAT(copy.key(), Eq(state.key()));
+    }
+
+    // The agent finds the immediate win, and blocks the opponent's.
+    TEST_F(ConnectFourTest, AgentPlaysTheObviousMoves)
+    {
+        GameAgent<ConnectFour>::debug_counters = false;
+        GameAgent<ConnectFour>::set_max_iter(2000);
+
+        play("445566");
+        {
+            GameAgent<ConnectFour> agent(state);
+            EXPECT_THAT(agent.MCTSBestMove(), AnyOf(Move(3), Move(7)));
+        }
+
+        state = ConnectFour();
+        n_moves = 0;
+        game_table<ConnectFour>.clear();
+
+        play("14151");
+        {
+            GameAgent<ConnectFour> agent(state);
+            EXPECT_THAT(agent.MCTSBestMove(), Eq(Move(1)));
+        }
+
+        game_table<ConnectFour>.clear();
+        GameAgent<ConnectFour>::set_max_iter(1000);
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,99 @@
+#include <array>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "solver.h"
+
+namespace mcts {
+namespace {
+
+    class DirectTableTest : public ::testing::Test {
+    protected:
+        DirectTableTest()
+        {
+            Agent::debug_counters = false;
+            Agent::direct_table = true;
+            Agent::clear_table();
+        }
+
+        ~DirectTableTest()
+        {
+            Agent::direct_table = false;
+            Agent::clear_table();
+        }
+
+        std::array<StateData, 9> sd;
+    };
+
+    using namespace ::testing;
+
+    TEST_F(DirectTableTest, NodesAreAtTheIndexOfTheirPosition)
+    {
+        State state;
+        state.apply_move(State::cellTokenToMove(Cell(4), X), sd[0]);
+
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        EXPECT_THAT(MCTS.size(), Eq(0u));
+        ASSERT_THAT(direct_nodes<State>.size(), Eq(size_t(State::INDEX_SIZE)));
+
+        const Node& root = direct_nodes<State>[state.index()];
+        EXPECT_THAT(root.key, Eq(state.key()));
+        EXPECT_THAT(root.n_visits, Gt(Agent::MAX_ITER));
+    }
+
+    // Every edge leads to the slot of the position after its move, so the paths
+    // reaching the same position share its node.
+    TEST_F(DirectTableTest, EdgesLeadToTheIndexAfterTheirMove)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        const Node* base = direct_nodes<State>.data();
+        int n_edges = 0;
+
+        for (int i = 0; i < State::INDEX_SIZE; ++i)
+        {
+            const Node& node = base[i];
+            for (int c = 0; c < node.n_children; ++c)
+            {
+                const ActionNode& edge = node.children[c];
+                if (!edge.child)
+                    continue;
+
+                int expected = i + State::moveToToken(edge.move) * State::POW3[State::moveToCell(edge.move)];
+
+                EXPECT_THAT(edge.child - base, Eq(expected));
+                EXPECT_THAT(edge.child->key, Eq(edge.child_key));
+                ++n_edges;
+            }
+        }
+        EXPECT_THAT(n_edges, Ge(Agent::MAX_ITER / 2));
+    }
+
+    TEST_F(DirectTableTest, PlaysThePerfectMoves)
+    {
+        Solver::Table table;
+        table.solve();
+
+        // X: 0 4, O: 8, X to move wins with 2 or 6 (a double threat).
+        State state;
+        int i = 0;
+        for (int cell : { 0, 8, 4 })
+            state.apply_move(State::cellTokenToMove(Cell(cell), state.next_player()), sd[i++]);
+
+        Agent agent(state);
+        Move move = agent.MCTSBestMove();
+        EXPECT_TRUE(table.is_perfect(state, move));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,209 @@
+#include <array>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "engine.h"
+
+namespace mcts {
+namespace {
+
+    // The engine is fed a script, as it would be on stdin, and its answers are
+    // collected once the script is over (loop() waits for the last search). The
+    // stats command doesn't wait for the search, setoption does.
+    class EngineTest : public ::testing::Test {
+    protected:
+        EngineTest()
+        {
+            MCTS.clear();
+            Agent::use_time = false;
+            Agent::set_max_iter(300);
+            Agent::set_max_time(5000);
+        }
+
+        ~EngineTest()
+        {
+            Agent::use_time = false;
+            Agent::set_max_iter(1000);
+            Agent::set_max_time(5000);
+            MCTS.clear();
+        }
+
+        std::vector<std::string> run(const std::string& script)
+        {
+            std::istringstream in(script);
+            std::ostringstream out;
+            {
+                Engine engine(out);
+                engine.loop(in);
+            }
+
+            std::vector<std::string> lines;
+            std::istringstream os(out.str());
+            for (std::string line; std::getline(os, line); )
+                if (line.rfind("info iterations", 0) != 0)    // The periodic updates.
+                    lines.push_back(line);
+            return lines;
+        }
+
+        static std::vector<std::string> bestmoves(const std::vector<std::string>& lines)
+        {
+            std::vector<std::string> moves;
+            for (const auto& line : lines)
+                if (line.rfind("bestmove", 0) == 0)
+                    moves.push_back(line);
+            return moves;
+        }
+    };
+
+    using namespace ::testing;
+
+    TEST_F(EngineTest, GoAnswersOnce)
+    {
+        auto lines = run("isready\n"
+                         "position startpos moves 5 1\n"
+                         "go iterations 200\n"
+                         "quit\n");
+
+        ASSERT_THAT(lines.size(), Ge(2u));
+        EXPECT_THAT(lines[0], Eq("readyok"));
+        EXPECT_THAT(bestmoves(lines), ElementsAre(AnyOf("bestmove 2", "bestmove 3", "bestmove 4", "bestmove 6",
+                                                        "bestmove 7", "bestmove 8", "bestmove 9")));
+    }
+
+    // The ponder search is stopped without an answer, the next go has its own.
+    TEST_F(EngineTest, StopWhilePonderingIsSilent)
+    {
+        auto lines = run("position startpos moves 5\n"
+                         "ponder\n"
+                         "stop\n"
+                         "position startpos moves 5 1\n"
+                         "ponder\n"
+                         "isready\n");
+
+        EXPECT_THAT(bestmoves(lines), IsEmpty());
+        EXPECT_THAT(lines, Contains("readyok"));
+    }
+
+    // Once the engine's move is played, the ponder search is rooted after the reply
+    // its go search expected, and that reply is taken back for the next command.
+    TEST_F(EngineTest, PonderSearchesAfterTheExpectedReply)
+    {
+        std::ostringstream out;
+        Engine engine(out);
+
+        std::istringstream go("position startpos moves 5 1\n"
+                              "go iterations 300\n");
+        engine.loop(go);
+        auto moves = bestmoves({ out.str().substr(out.str().rfind("bestmove")) });
+        ASSERT_THAT(moves.size(), Eq(1u));
+        int cell = std::stoi(moves[0].substr(9));
+
+        State state;
+        std::array<StateData, 3> sd;
+        int i = 0;
+        for (int c : { 5, 1, cell })
+            state.apply_move(State::cellTokenToMove(Cell(c - 1), state.next_player()), sd[i++]);
+
+        // Only the ponder search's nodes, which it stops before it has any other.
+        MCTS.clear();
+        std::istringstream ponder("position startpos moves 5 1 " + std::to_string(cell) + "\n"
+                                  "ponder\n");
+        engine.loop(ponder);
+
+        EXPECT_THAT(MCTS.count(state.key()), Eq(0u));
+        int n_replies = 0;
+        for (Move reply : state.valid_actions())
+            n_replies += MCTS.count(state.key_after(reply)) > 0;
+        EXPECT_THAT(n_replies, Ge(1));
+
+        std::istringstream next("go iterations 50\n");
+        engine.loop(next);
+        ASSERT_THAT(MCTS.count(state.key()), Eq(1u));
+        EXPECT_THAT(MCTS[state.key()].n_visits, Gt(0));
+    }
+
+    TEST_F(EngineTest, StopAnswersAnInfiniteSearch)
+    {
+        auto lines = run("position startpos moves 1 5\n"
+                         "go infinite\n"
+                         "stop\n"
+                         "stop\n");
+
+        auto moves = bestmoves(lines);
+        ASSERT_THAT(moves.size(), Eq(1u));
+        EXPECT_THAT(moves[0], Not(AnyOf("bestmove 1", "bestmove 5", "bestmove none")));
+    }
+
+    TEST_F(EngineTest, GoOptionsOnlyLastOneSearch)
+    {
+        run("go movetime 30\n"
+            "go iterations 50\n"
+            "go infinite\n"
+            "stop\n"
+            "ponder\n");
+
+        EXPECT_FALSE(Agent::use_time);
+        EXPECT_THAT(Agent::MAX_ITER, Eq(300));
+        EXPECT_THAT(Agent::MAX_TIME, Eq(5000));
+    }
+
+    // The movetime is the search's own, the margin of computation_resources() on top.
+    TEST_F(EngineTest, MovetimeIsSearched)
+    {
+        auto lines = run("go movetime 20\n"
+                         "setoption name info_period value 250\n"    // Waits for the search.
+                         "stats\n");
+
+        ASSERT_THAT(bestmoves(lines).size(), Eq(1u));
+        ASSERT_THAT(lines.back(), StartsWith("info string nodes"));
+        EXPECT_THAT(lines.back(), Not(EndsWith("iterations 0")));
+    }
+
+    TEST_F(EngineTest, SetOptionChangesTheBudget)
+    {
+        auto lines = run("setoption name max_iter value 120\n"
+                         "setoption name no_such_knob value 1\n"
+                         "go iterations 10\n"
+                         "setoption name info_period value 250\n"
+                         "stats\n");
+
+        EXPECT_THAT(Agent::MAX_ITER, Eq(120));
+        EXPECT_THAT(lines, Contains("info string unknown option no_such_knob"));
+        EXPECT_THAT(lines.back(), EndsWith("iterations 10"));
+    }
+
+    TEST_F(EngineTest, IllegalMovesAreReported)
+    {
+        auto lines = run("position startpos moves 5 5\n"
+                         "go iterations 50\n"
+                         "frobnicate\n");
+
+        EXPECT_THAT(lines, Contains("info string illegal move 5"));
+        EXPECT_THAT(lines, Contains("info string unknown command frobnicate"));
+        EXPECT_THAT(bestmoves(lines).size(), Eq(1u));
+    }
+
+    // The shared table and the cache die with their engine, the next agents don't see them.
+    TEST_F(EngineTest, DestructionUnplugsTheSharedState)
+    {
+        const std::string name = "/mcts_test_engine";
+        auto lines = run("setoption name cache value 16\n"
+                         "setoption name shared value " + name + "\n"
+                         "go iterations 50\n");
+        SharedTable::unlink(name);
+
+        ASSERT_THAT(bestmoves(lines).size(), Eq(1u));
+        EXPECT_THAT(Agent::decision_cache, IsNull());
+        EXPECT_THAT(Agent::shared_table, IsNull());
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
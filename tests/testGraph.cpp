@@ -0,0 +1,115 @@
+#include <array>
+#include <stdexcept>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    // X in the corners 0 and 8 and O in the center, by the two orders of X's moves.
+    class GraphTest : public ::testing::Test {
+    protected:
+        GraphTest()
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+            Agent::set_max_iter(500);
+        }
+
+        ~GraphTest()
+        {
+            Agent::graph_search = false;
+            MCTS.clear();
+        }
+
+        State play(std::vector<int> cells, int offset)
+        {
+            State state;
+            for (size_t i = 0; i < cells.size(); ++i)
+                state.apply_move(State::cellTokenToMove(Cell(cells[i]), state.next_player()), sd[offset + i]);
+            return state;
+        }
+
+        static const ActionNode& edge(const State& from, int cell)
+        {
+            const Node& node = MCTS[from.key()];
+            for (int i = 0; i < node.n_children; ++i)
+                if (State::moveToCell(node.children[i].move) == cell)
+                    return node.children[i];
+            throw std::logic_error("no such edge");
+        }
+
+        std::array<StateData, 4> sd;
+        State a = play({ 0, 4 }, 0);    // X8 next.
+        State b = play({ 8, 4 }, 2);    // X0 next.
+    };
+
+    using namespace ::testing;
+
+    TEST_F(GraphTest, TranspositionsShareTheChildValue)
+    {
+        Agent::graph_search = true;
+
+        Agent agent_a(a);
+        agent_a.MCTSBestMove();
+
+        // A single path to every child so far: the values are the edges' own.
+        const Node& root_a = MCTS[a.key()];
+        for (int i = 0; i < root_a.n_children; ++i)
+        {
+            const ActionNode& c = root_a.children[i];
+            if (c.n_visits > 0)
+            {
+                EXPECT_THAT(agent_a.child_value(&c), DoubleEq(c.avg_action_value));
+            }
+        }
+
+        Agent agent_b(b);
+        agent_b.MCTSBestMove();
+
+        const ActionNode& ea = edge(a, 8);
+        const ActionNode& eb = edge(b, 0);
+        ASSERT_THAT(ea.child_key, Eq(eb.child_key));
+        ASSERT_THAT(ea.n_visits, Gt(0));
+        ASSERT_THAT(eb.n_visits, Gt(0));
+
+        // The shared node has every update of both edges, and both read its mean.
+        const Node& shared = MCTS[ea.child_key];
+        Reward pooled = (ea.action_value + eb.action_value) / (ea.n_visits + eb.n_visits);
+
+        EXPECT_THAT(shared.n_updates, Eq(ea.n_visits + eb.n_visits));
+        EXPECT_THAT(agent_a.child_value(&ea), DoubleNear(pooled, 1e-9));
+        EXPECT_THAT(agent_b.child_value(&eb), DoubleNear(pooled, 1e-9));
+    }
+
+    TEST_F(GraphTest, TreeModeReadsTheEdges)
+    {
+        Agent agent_a(a);
+        agent_a.MCTSBestMove();
+        Agent agent_b(b);
+        agent_b.MCTSBestMove();
+
+        const ActionNode& ea = edge(a, 8);
+        const ActionNode& eb = edge(b, 0);
+        ASSERT_THAT(ea.child_key, Eq(eb.child_key));
+
+        EXPECT_THAT(agent_a.child_value(&ea), DoubleEq(ea.avg_action_value));
+        EXPECT_THAT(agent_b.child_value(&eb), DoubleEq(eb.avg_action_value));
+
+        // The node's statistics are kept all the same, the graph mode reads them.
+        Agent::graph_search = true;
+        Reward pooled = (ea.action_value + eb.action_value) / (ea.n_visits + eb.n_visits);
+        EXPECT_THAT(agent_a.child_value(&ea), DoubleNear(pooled, 1e-9));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
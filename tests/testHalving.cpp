@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    class HalvingTest : public ::testing::Test {
+    protected:
+        HalvingTest()
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+            Agent::root_halving = true;
+        }
+
+        ~HalvingTest()
+        {
+            Agent::root_halving = false;
+            Agent::halving_top_k = 0;
+            Agent::set_max_iter(1000);
+            MCTS.clear();
+        }
+
+        static std::vector<int> sorted_visits(const Node& root)
+        {
+            std::vector<int> visits;
+            for (int i = 0; i < root.n_children; ++i)
+                visits.push_back(root.children[i].n_visits);
+            std::sort(visits.begin(), visits.end());
+            return visits;
+        }
+    };
+
+    using namespace ::testing;
+
+    // Nine children, four rounds: each round has a fourth of what is left, split
+    // between its candidates, and the last one has the remainder.
+    TEST_F(HalvingTest, BudgetIsSplitByRound)
+    {
+        Agent::set_max_iter(1000);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        // 1000 / (4*9) = 27, 757 / (3*5) = 50, 507 / (2*3) = 84, then 255 for two.
+        const Node& root = MCTS[state.key()];
+        EXPECT_THAT(sorted_visits(root), ElementsAre(27, 27, 27, 27, 77, 77, 161, 288, 289));
+        EXPECT_THAT(agent.info().iterations, Eq(1000));
+    }
+
+    // Only the first children by prior enter the halving, none of the budget goes elsewhere.
+    TEST_F(HalvingTest, TopKTakesTheWholeBudget)
+    {
+        Agent::halving_top_k = 4;
+        Agent::set_max_iter(401);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        const Node& root = MCTS[state.key()];
+        EXPECT_THAT(sorted_visits(root), ElementsAre(0, 0, 0, 0, 0, 50, 50, 150, 151));
+    }
+
+    TEST_F(HalvingTest, PlaysTheBestSurvivor)
+    {
+        Agent::set_max_iter(600);
+
+        State state;
+        Agent agent(state);
+        Move move = agent.MCTSBestMove();
+
+        // The survivors are the two most visited, the best of them by value is played.
+        const Node& root = MCTS[state.key()];
+        std::vector<const ActionNode*> edges;
+        for (int i = 0; i < root.n_children; ++i)
+            edges.push_back(&root.children[i]);
+        std::sort(edges.begin(), edges.end(), [](const auto* a, const auto* b) { return a->n_visits > b->n_visits; });
+
+        const ActionNode* best = agent.child_value(edges[0]) >= agent.child_value(edges[1]) ? edges[0] : edges[1];
+        EXPECT_THAT(move, Eq(best->move));
+        EXPECT_THAT(edges[1]->n_visits, Gt(edges[2]->n_visits));
+    }
+
+    // A stop in the middle of a round answers the leader of the last one, which is
+    // also what the search returns and what info() reports.
+    TEST_F(HalvingTest, StopAnswersWhatTheSearchPlays)
+    {
+        // The last round, of two candidates, starts after 14996 iterations.
+        Agent::set_max_iter(20000);
+
+        State state;
+        Agent agent(state);
+        Move stopped = MOVE_NONE;
+        agent.set_update([&](const SearchInfo& si) {
+                if (si.iterations >= 15000 && stopped == MOVE_NONE)
+                {
+                    agent.stop();
+                    stopped = agent.best_so_far();
+                }
+            }, 1);
+
+        Move move = agent.MCTSBestMove();
+        SearchInfo si = agent.info();
+
+        ASSERT_THAT(stopped, Ne(MOVE_NONE));
+        EXPECT_THAT(si.iterations, Lt(20000));
+        EXPECT_THAT(move, Eq(stopped));
+        EXPECT_THAT(si.best_move, Eq(move));
+        ASSERT_THAT(si.pv, Not(IsEmpty()));
+        EXPECT_THAT(si.pv[0], Eq(move));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
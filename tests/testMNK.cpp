@@ -0,0 +1,188 @@
+#include <array>
+#include <random>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "mnk.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    using TicTacToe = MNKGame<3, 3, 3>;
+
+    TEST(BitboardTest, ShiftsCrossTheWords)
+    {
+        Bitboard<240> b;
+        b.set(63);
+        b.set(130);
+
+        auto up = b.shifted(1);
+        EXPECT_TRUE(up.test(64));
+        EXPECT_TRUE(up.test(131));
+        EXPECT_THAT(up.count(), Eq(2));
+
+        auto down = b.shifted(-64);
+        EXPECT_TRUE(down.test(66));
+        EXPECT_THAT(down.count(), Eq(1));    // Bit 63 went past the end.
+
+        EXPECT_FALSE(b.shifted(200).any());
+    }
+
+    // The 3,3,3-game is tic-tac-toe: random games end in the same way.
+    TEST(MNKTest, SameGamesAsTicTacToe)
+    {
+        std::mt19937 rng(11);
+
+        for (int g = 0; g < 500; ++g)
+        {
+            State ttt;
+            TicTacToe mnk;
+            std::array<StateData, 10> sd1, sd2;
+
+            for (int i = 0; !ttt.is_terminal(); ++i)
+            {
+                ASSERT_FALSE(mnk.is_terminal());
+                ASSERT_THAT(mnk.valid_actions().size(), Eq(ttt.valid_actions().size()));
+
+                Move m = mnk.valid_actions()[rng() % mnk.valid_actions().size()];
+                Cell cell = Cell(m - 1);
+                ttt.apply_move(State::cellTokenToMove(cell, ttt.next_player()), sd1[i]);
+                mnk.apply_move(m, sd2[i]);
+            }
+
+            EXPECT_TRUE(mnk.is_terminal());
+            EXPECT_THAT(mnk.winner(), Eq(ttt.winner()));
+            EXPECT_THAT(mnk.is_draw(), Eq(ttt.is_draw()));
+            EXPECT_THAT(TicTacToe::terminal_value(*mnk.data), DoubleEq(key_ev_terminal(*ttt.data)));
+        }
+    }
+
+    class GomokuTest : public ::testing::Test {
+    protected:
+        void play(std::vector<std::pair<int, int>> squares)
+        {
+            for (auto [r, c] : squares)
+            {
+                Move move = Gomoku::rowColToMove(r, c);
+                ASSERT_TRUE(state.is_valid(move));
+                state.apply_move(move, sd[n_moves++]);
+            }
+        }
+
+        Gomoku state;
+        std::array<StateData, Gomoku::MAX_GAME_PLY + 1> sd;
+        int n_moves = 0;
+    };
+
+    TEST_F(GomokuTest, FiveInARowWins)
+    {
+        // X on the anti-diagonal from (4, 10), O away from it.
+        play({ {4, 10}, {0, 0}, {5, 9}, {0, 2}, {6, 8}, {0, 4}, {7, 7}, {0, 6} });
+        EXPECT_FALSE(state.is_terminal());
+
+        play({ {8, 6} });
+        EXPECT_TRUE(state.is_terminal());
+        EXPECT_THAT(state.winner(), Eq(X));
+        EXPECT_TRUE(Gomoku::is_win(state.board(X)));
+        EXPECT_FALSE(Gomoku::is_win(state.board(O)));
+    }
+
+    // The end of a row and the start of the next one aren't a line.
+    TEST_F(GomokuTest, NoWinAcrossRows)
+    {
+        play({ {3, 12}, {10, 0}, {3, 13}, {10, 2}, {3, 14}, {10, 4}, {4, 0}, {10, 6}, {4, 1} });
+        EXPECT_FALSE(state.is_terminal());
+        EXPECT_THAT(state.winner(), Eq(TOK_EMPTY));
+    }
+
+    TEST_F(GomokuTest, KeysAreIncremental)
+    {
+        std::mt19937 rng(3);
+        std::array<Key, Gomoku::MAX_GAME_PLY + 1> keys;
+        std::array<Move, Gomoku::MAX_GAME_PLY + 1> moves;
+
+        while (!state.is_terminal())
+        {
+            keys[n_moves] = state.key();
+            auto& actions = state.valid_actions();
+            Move move = actions[rng() % actions.size()];
+            Key after = state.key_after(move);
+
+            moves[n_moves] = move;
+            state.apply_move(move, sd[n_moves++]);
+            ASSERT_THAT(state.key(), Eq(after));
+            ASSERT_THAT(state.is_terminal(), Eq(Gomoku::is_win(state.board(X)) || Gomoku::is_win(state.board(O))
+                                                || state.is_full()));
+        }
+
+        while (n_moves > 0)
+        {
+            state.undo_move(moves[--n_moves]);
+            ASSERT_THAT(state.key(), Eq(keys[n_moves]));
+        }
+        EXPECT_THAT(state.valid_actions().size(), Eq(225u));
+    }
+
+    TEST_F(GomokuTest, PriorFavorsTheSquaresNearTheStones)
+    {
+        EXPECT_THAT(state.prior(Gomoku::rowColToMove(7, 7)), Gt(state.prior(Gomoku::rowColToMove(0, 0))));
+
+        play({ {2, 2} });
+        EXPECT_THAT(state.prior(Gomoku::rowColToMove(3, 3)), Gt(state.prior(Gomoku::rowColToMove(4, 4))));
+        EXPECT_THAT(state.prior(Gomoku::rowColToMove(4, 4)), Gt(state.prior(Gomoku::rowColToMove(7, 7))));
+    }
+
+    // Every move is a child, the likeliest ones coming in first with the visits.
+    TEST_F(GomokuTest, WideningBoundsTheChildren)
+    {
+        using GomokuAgent = GameAgent<Gomoku>;
+
+        GomokuAgent::debug_counters = false;
+        GomokuAgent::widening_cst = 1;
+        GomokuAgent::set_max_iter(400);
+
+        // X has an open four, and wins on either end.
+        play({ {7, 5}, {0, 0}, {7, 6}, {0, 14}, {7, 7}, {14, 0}, {7, 8}, {14, 14} });
+
+        GomokuAgent agent(state);
+        Move move = agent.MCTSBestMove();
+        EXPECT_THAT(move, AnyOf(Gomoku::rowColToMove(7, 4), Gomoku::rowColToMove(7, 9)));
+
+        const auto& root = game_table<Gomoku>.at(state.key());
+        EXPECT_THAT(root.n_children, Eq(15 * 15 - 8));
+        EXPECT_THAT(root.n_expanded_children, Le(agent.widening_at(root.n_visits)));
+        EXPECT_THAT(root.n_expanded_children, Lt(root.n_children));
+
+        game_table<Gomoku>.clear();
+        GomokuAgent::widening_cst = 0;
+        GomokuAgent::set_max_iter(1000);
+    }
+
+    // The widening reaches every square of the board, and doesn't ask for more.
+    TEST_F(GomokuTest, WideningReachesEverySquare)
+    {
+        using GomokuAgent = GameAgent<Gomoku>;
+
+        GomokuAgent agent(state);
+        GomokuAgent::widening_cst = 1;
+        EXPECT_THAT(max_children<Gomoku>(), Eq(15 * 15));
+        EXPECT_THAT(agent.widening_at(1), Eq(1));
+        EXPECT_THAT(agent.widening_at(15 * 15 * 15 * 15), Eq(15 * 15));
+        EXPECT_THAT(agent.widening_at(1 << 30), Eq(15 * 15));
+
+        GomokuAgent::widening_cst = 0;
+        EXPECT_THAT(agent.widening_at(1), Eq(max_children<Gomoku>()));
+        game_table<Gomoku>.clear();
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
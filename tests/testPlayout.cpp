@@ -0,0 +1,175 @@
+#include <array>
+#include <numeric>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "playout.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    using Playout::Board;
+
+    // Value of the empty board for X, who moves first: in random games, X wins
+    // 58.5% of them and 12.7% are draws.
+    constexpr double X_VALUE = 0.585 + 0.127 / 2;
+
+    TEST(PlayoutTest, BoardsAlreadyOver)
+    {
+        std::array<Board, 2> boards = { {
+            { 0x018, 0x007 },    // Lost: the other player has the first row.
+            { 0x072, 0x18D },    // Drawn: full without a line.
+        } };
+        std::array<Reward, 2> values;
+
+        Playout::run(boards.data(), 2, values.data(), 1);
+        EXPECT_THAT(values[0], DoubleEq(0));
+        EXPECT_THAT(values[1], DoubleEq(0.5));
+    }
+
+    // The only empty cell, 0, completes the first row of the player to move.
+    TEST(PlayoutTest, LastMoveWins)
+    {
+        Board board { 0x08E, 0x170 };
+        Reward value;
+
+        Playout::run(&board, 1, &value, 7);
+        EXPECT_THAT(value, DoubleEq(1));
+    }
+
+    TEST(PlayoutTest, RandomGamesFromTheEmptyBoard)
+    {
+        const int n = 200000;
+        std::vector<Board> boards(n, Board { 0, 0 });
+        std::vector<Reward> values(n);
+
+        Playout::run(boards.data(), n, values.data(), 42);
+
+        // From X's point of view, as X is to move.
+        double mean = std::accumulate(values.begin(), values.end(), 0.0) / n;
+        EXPECT_THAT(mean, DoubleNear(X_VALUE, 0.005));
+    }
+
+    TEST(PlayoutTest, KernelsAgree)
+    {
+        if (!Playout::has_avx2())
+            GTEST_SKIP() << "No AVX2";
+
+        std::vector<Board> boards;
+        for (uint16_t x = 0; x < 512; x += 7)
+            boards.push_back({ uint16_t(x & 0x0AA), uint16_t(~x & 0x101) });
+        boards.resize(boards.size() + 3, Board { 0, 0 });    // Not a multiple of 8.
+
+        std::vector<Reward> scalar(boards.size()), simd(boards.size());
+        Playout::run_scalar(boards.data(), boards.size(), scalar.data(), 99);
+        Playout::run_avx2(boards.data(), boards.size(), simd.data(), 99);
+
+        EXPECT_THAT(simd, ContainerEq(scalar));
+    }
+
+    TEST(PlayoutTest, AgentFindsTheWinWithBatchedPlayouts)
+    {
+        Agent::debug_counters = false;
+        Agent::simd_playouts = true;
+        Agent::leaf_playouts = 8;
+        MCTS.clear();
+
+        // X: 0 4, O: 1 2, X to move wins on 8.
+        State state;
+        std::array<StateData, 4> sd;
+        int i = 0;
+        for (int cell : { 0, 1, 4, 2 })
+            state.apply_move(State::cellTokenToMove(Cell(cell), state.next_player()), sd[i++]);
+
+        Agent agent(state);
+        EXPECT_THAT(agent.MCTSBestMove(), Eq(State::cellTokenToMove(Cell(8), X)));
+
+        Agent::simd_playouts = false;
+        Agent::leaf_playouts = 0;
+        MCTS.clear();
+    }
+
+    // The playouts of a leaf weigh as many visits, on the leaf and on the path to it.
+    TEST(PlayoutTest, LeafPlayoutsWeighTheirVisits)
+    {
+        Agent::debug_counters = false;
+        Agent::use_time = false;
+        Agent::leaf_playouts = 8;
+        Agent::set_max_iter(1);
+        MCTS.clear();
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        const Node& root = MCTS[state.key()];
+        const ActionNode* edge = nullptr;
+        for (int i = 0; i < root.n_children; ++i)
+            if (root.children[i].n_visits > 0)
+                edge = &root.children[i];
+
+        ASSERT_THAT(edge, NotNull());
+        EXPECT_THAT(edge->n_visits, Eq(8));
+        EXPECT_THAT(root.n_visits, Eq(9));
+
+        const Node& leaf = MCTS[state.key_after(edge->move)];
+        EXPECT_THAT(leaf.n_visits, Eq(8));
+        EXPECT_THAT(leaf.n_updates, Eq(8));
+
+        Agent::leaf_playouts = 0;
+        Agent::set_max_iter(1000);
+        MCTS.clear();
+    }
+
+    // Nine leaves one ply below the root, each visited first, then one two plies below.
+    TEST(PlayoutTest, PlayoutsDecayWithTheDepth)
+    {
+        Agent::debug_counters = false;
+        Agent::use_time = false;
+        Agent::leaf_playouts = 8;
+        Agent::playouts_decay = 3;
+        Agent::set_max_iter(10);
+        MCTS.clear();
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        const Node& root = MCTS[state.key()];
+        std::vector<int> visits;
+        const ActionNode* deeper = nullptr;
+        for (int i = 0; i < root.n_children; ++i)
+        {
+            visits.push_back(root.children[i].n_visits);
+            if (root.children[i].n_visits > 5)
+                deeper = &root.children[i];
+        }
+
+        EXPECT_THAT(visits, UnorderedElementsAre(5, 5, 5, 5, 5, 5, 5, 5, 7));
+        EXPECT_THAT(root.n_visits, Eq(1 + 8 * 5 + 7));
+
+        ASSERT_THAT(deeper, NotNull());
+        const Node& child = MCTS[state.key_after(deeper->move)];
+        EXPECT_THAT(child.n_visits, Eq(5 + 1 + 1));
+        int below = 0;
+        for (int i = 0; i < child.n_children; ++i)
+            below += child.children[i].n_visits;
+        EXPECT_THAT(below, Eq(2));
+
+        Agent::leaf_playouts = 0;
+        Agent::playouts_decay = 0;
+        Agent::set_max_iter(1000);
+        MCTS.clear();
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
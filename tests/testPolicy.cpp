@@ -0,0 +1,124 @@
+#include <array>
+#include <random>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    template<class A>
+    class PolicyTest : public ::testing::Test {
+    protected:
+        PolicyTest()
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::use_time = false;
+            Agent::set_max_iter(3000);
+        }
+
+        ~PolicyTest()
+        {
+            Agent::set_max_iter(1000);
+            MCTS.clear();
+        }
+
+        // The cell chosen by the agent after the given moves, X first.
+        int best_cell(std::vector<int> cells)
+        {
+            State state;
+            for (size_t i = 0; i < cells.size(); ++i)
+                state.apply_move(State::cellTokenToMove(Cell(cells[i]), state.next_player()), sd[i]);
+
+            A agent(state);
+            return State::moveToCell(agent.MCTSBestMove());
+        }
+
+        std::array<StateData, 9> sd;
+    };
+
+    using Agents = ::testing::Types<
+        BasicAgent<State, Policy::UCB1,      Policy::MostVisits>,
+        BasicAgent<State, Policy::UCB1,      Policy::BestValue>,
+        BasicAgent<State, Policy::UCB1Tuned, Policy::MostVisits>,
+        BasicAgent<State, Policy::UCB1Tuned, Policy::BestValue>,
+        BasicAgent<State, Policy::Thompson,  Policy::MostVisits>,
+        BasicAgent<State, Policy::Thompson,  Policy::BestValue>,
+        BasicAgent<State, Policy::PUCT,      Policy::MostVisits>,
+        BasicAgent<State, Policy::PUCT,      Policy::BestValue>>;
+
+    TYPED_TEST_SUITE(PolicyTest, Agents);
+
+    using namespace ::testing;
+
+    TYPED_TEST(PolicyTest, TakesTheWin)
+    {
+        EXPECT_THAT(this->best_cell({ 0, 3, 1, 4 }), Eq(2));       // X wins on the top row.
+        EXPECT_THAT(this->best_cell({ 0, 4, 1, 5, 6 }), Eq(3));    // O wins on the middle row, or loses.
+    }
+
+    TYPED_TEST(PolicyTest, BlocksTheThreat)
+    {
+        EXPECT_THAT(this->best_cell({ 0, 4, 1 }), Eq(2));          // O blocks the top row.
+        EXPECT_THAT(this->best_cell({ 4, 0, 8, 1 }), Eq(2));       // X blocks O's top row.
+        EXPECT_THAT(this->best_cell({ 4, 0, 6 }), Eq(2));          // O blocks the diagonal.
+    }
+
+    // Same mean, the edge with the spread out rewards is explored more.
+    TEST(UCB1TunedTest, ScoresTheVariance)
+    {
+        Node node;
+        node.n_visits = 20000;
+
+        ActionNode steady, spread;
+        steady.n_visits = spread.n_visits = 10000;
+        steady.action_value = spread.action_value = 5000;
+        steady.sq_action_value = 10000 * 0.5 * 0.5;    // Always 0.5.
+        spread.sq_action_value = 5000;                 // Half wins, half losses.
+
+        std::mt19937 rng;
+        double a = Policy::UCB1Tuned::score(node, steady, 0.5, 1.0, rng);
+        double b = Policy::UCB1Tuned::score(node, spread, 0.5, 1.0, rng);
+        EXPECT_THAT(b, Gt(a));
+
+        // The plain UCB1 doesn't tell them apart.
+        EXPECT_THAT(Policy::UCB1::score(node, steady, 0.5, 1.0, rng),
+                    DoubleEq(Policy::UCB1::score(node, spread, 0.5, 1.0, rng)));
+    }
+
+    // The descents keep the squared rewards the policy reads.
+    TEST(UCB1TunedTest, SearchKeepsTheSquaredRewards)
+    {
+        MCTS.clear();
+        Agent::debug_counters = false;
+        Agent::use_time = false;
+        Agent::set_max_iter(500);
+
+        State state;
+        BasicAgent<State, Policy::UCB1Tuned> agent(state);
+        agent.MCTSBestMove();
+
+        const Node& root = MCTS[state.key()];
+        for (int i = 0; i < root.n_children; ++i)
+        {
+            const ActionNode& e = root.children[i];
+            ASSERT_THAT(e.n_visits, Gt(0));
+            EXPECT_THAT(e.sq_action_value > 0, Eq(e.action_value > 0));    // Not if it only lost.
+            EXPECT_THAT(e.sq_action_value, Le(e.action_value + 1e-9));    // Rewards are in [0, 1].
+            EXPECT_THAT(e.sq_action_value * e.n_visits, Ge(e.action_value * e.action_value - 1e-9));
+        }
+
+        Agent::set_max_iter(1000);
+        MCTS.clear();
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+
+namespace mcts {
+namespace {
+
+    class ProfileTest : public ::testing::Test {
+    protected:
+        ProfileTest()
+        {
+            Agent::save_profile(defaults);
+        }
+
+        ~ProfileTest()
+        {
+            Agent::load_profile(defaults);
+            std::remove(path.c_str());
+            std::remove(defaults.c_str());
+        }
+
+        void write(const std::string& text)
+        {
+            std::ofstream ofs(path);
+            ofs << text;
+        }
+
+        std::string path = "testProfile.profile";
+        std::string defaults = "testProfile.defaults";
+    };
+
+    using namespace ::testing;
+
+    TEST_F(ProfileTest, SavedKnobsAreLoadedBack)
+    {
+        Agent::exploration_cst = 1.25;
+        Agent::n_rollouts = 3;
+        Agent::ab_threshold = 4;
+        Agent::max_bytes = 1 << 20;
+        Agent::root_halving = true;
+        Agent::widening_exp = 0.75;
+        ASSERT_TRUE(Agent::save_profile(path));
+
+        Agent::load_profile(defaults);
+        ASSERT_THAT(Agent::exploration_cst, Ne(1.25));
+
+        ASSERT_TRUE(Agent::load_profile(path));
+        EXPECT_THAT(Agent::exploration_cst, DoubleEq(1.25));
+        EXPECT_THAT(Agent::n_rollouts, Eq(3));
+        EXPECT_THAT(Agent::ab_threshold, Eq(4));
+        EXPECT_THAT(Agent::max_bytes, Eq(size_t(1) << 20));
+        EXPECT_TRUE(Agent::root_halving);
+        EXPECT_THAT(Agent::widening_exp, DoubleEq(0.75));
+    }
+
+    // Older binaries read the profiles of newer ones.
+    TEST_F(ProfileTest, UnknownKnobsAreSkipped)
+    {
+        write("exploration_cst 0.9\n"
+              "no_such_knob 12 13\n"
+              "n_rollouts 5\n");
+
+        ASSERT_TRUE(Agent::load_profile(path));
+        EXPECT_THAT(Agent::exploration_cst, DoubleEq(0.9));
+        EXPECT_THAT(Agent::n_rollouts, Eq(5));
+    }
+
+    TEST_F(ProfileTest, CommentsAndBlankLinesAreSkipped)
+    {
+        write("# Tuned at 200 iterations\n"
+              "\n"
+              "#n_rollouts 7\n"
+              "# n_rollouts 8\n"
+              "leaf_playouts 2\n");
+
+        int n_rollouts = Agent::n_rollouts;
+        ASSERT_TRUE(Agent::load_profile(path));
+        EXPECT_THAT(Agent::n_rollouts, Eq(n_rollouts));
+        EXPECT_THAT(Agent::leaf_playouts, Eq(2));
+    }
+
+    TEST_F(ProfileTest, MissingProfileFails)
+    {
+        EXPECT_FALSE(Agent::load_profile(path + ".missing"));
+    }
+
+    TEST_F(ProfileTest, SetOptionByName)
+    {
+        EXPECT_TRUE(Agent::set_option("max_iter", " 321"));
+        EXPECT_THAT(Agent::MAX_ITER, Eq(321));
+
+        EXPECT_TRUE(Agent::set_option("use_time", "1"));
+        EXPECT_TRUE(Agent::use_time);
+
+        EXPECT_FALSE(Agent::set_option("no_such_knob", "1"));
+    }
+
+    // The knobs counting things can't go below one.
+    TEST_F(ProfileTest, SetOptionClampsCounts)
+    {
+        EXPECT_TRUE(Agent::set_option("n_rollouts", "0"));
+        EXPECT_THAT(Agent::n_rollouts, Eq(1));
+
+        EXPECT_TRUE(Agent::set_option("batch_size", "-4"));
+        EXPECT_THAT(Agent::batch_size, Eq(1));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "records.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    class RecordsTest : public ::testing::Test {
+    protected:
+        void TearDown() override
+        {
+            std::remove(path.c_str());
+        }
+
+        // A game of random moves, its visits made up from the game number.
+        static GameRecord record(int game)
+        {
+            std::mt19937 rng(game);
+            GameRecord r;
+            State state;
+            std::array<StateData, 10> sd;
+
+            for (int i = 0; !state.is_terminal(); ++i)
+            {
+                auto& moves = state.valid_actions();
+                Move move = moves[rng() % moves.size()];
+
+                SearchInfo si;
+                si.iterations = game;
+                for (Move m : moves)
+                    si.root_visits.emplace_back(m, m == move ? game + i : i);
+
+                r.add(move, si);
+                state.apply_move(move, sd[i]);
+            }
+            r.winner = state.winner();
+            return r;
+        }
+
+        static bool same(const GameRecord& a, const GameRecord& b)
+        {
+            return std::memcmp(&a, &b, sizeof(GameRecord)) == 0;
+        }
+
+        void write(int n_games, bool compress)
+        {
+            RecordWriter writer;
+            ASSERT_TRUE(writer.open(path, compress));
+            {
+                RecordWriter::Buffer buffer(writer);
+                for (int g = 0; g < n_games; ++g)
+                    buffer.add(record(g));
+            }
+            ASSERT_TRUE(writer.close());
+            EXPECT_THAT(writer.n_records(), Eq(uint64_t(n_games)));
+        }
+
+        std::string path = "testRecords." + std::to_string(::getpid()) + ".bin";
+    };
+
+    TEST_F(RecordsTest, CodecRoundTrip)
+    {
+        std::mt19937 rng(7);
+        for (int n : { 0, 1, 2, 127, 128, 129, 1000 })
+        {
+            std::vector<uint8_t> data(n), out;
+            for (auto& b : data)
+                b = rng() % 3 ? 0 : rng();    // Mostly zeros, some runs of literals.
+
+            Records::compress(data.data(), data.size(), out);
+
+            std::vector<uint8_t> back(n);
+            ASSERT_TRUE(Records::decompress(out.data(), out.size(), back.data(), back.size()));
+            EXPECT_THAT(back, Eq(data));
+        }
+    }
+
+    TEST_F(RecordsTest, RecordAddsThePlies)
+    {
+        GameRecord r = record(3);
+        ASSERT_THAT(r.n_plies, Ge(5));
+
+        for (int p = 0; p < r.n_plies; ++p)
+            EXPECT_THAT(r.plies[p].visits[r.plies[p].cell], Eq(3 + p));
+        EXPECT_THAT(r.iterations, Eq(3u * r.n_plies));
+    }
+
+    // The records of an uncompressed file are read in place, in the mapping.
+    TEST_F(RecordsTest, RawRoundTrip)
+    {
+        write(600, false);
+
+        RecordReader reader;
+        ASSERT_TRUE(reader.open(path));
+        EXPECT_FALSE(reader.compressed());
+        ASSERT_THAT(reader.size(), Eq(600u));
+
+        for (int g = 0; g < 600; ++g)
+        {
+            const GameRecord* r = reader.next();
+            ASSERT_THAT(r, NotNull());
+            EXPECT_TRUE(same(*r, record(g)));
+        }
+        EXPECT_THAT(reader.next(), IsNull());
+
+        reader.rewind();
+        EXPECT_TRUE(same(*reader.next(), record(0)));
+    }
+
+    TEST_F(RecordsTest, CompressedRoundTrip)
+    {
+        write(600, true);
+
+        RecordReader reader;
+        ASSERT_TRUE(reader.open(path));
+        EXPECT_TRUE(reader.compressed());
+        ASSERT_THAT(reader.size(), Eq(600u));
+
+        for (int g = 0; g < 600; ++g)
+        {
+            const GameRecord* r = reader.next();
+            ASSERT_THAT(r, NotNull());
+            EXPECT_TRUE(same(*r, record(g)));
+        }
+        EXPECT_THAT(reader.next(), IsNull());
+    }
+
+    TEST_F(RecordsTest, CompressionSavesSpace)
+    {
+        RecordWriter writer;
+        ASSERT_TRUE(writer.open(path, true));
+        {
+            RecordWriter::Buffer buffer(writer);
+            for (int g = 0; g < 300; ++g)
+                buffer.add(record(g));
+        }
+        ASSERT_TRUE(writer.close());
+
+        EXPECT_THAT(writer.bytes_written(), Lt(300 * sizeof(GameRecord) / 2));
+    }
+
+    // Each thread fills its own buffer, every record gets to the file once.
+    TEST_F(RecordsTest, ConcurrentBuffers)
+    {
+        RecordWriter writer;
+        ASSERT_TRUE(writer.open(path, true));
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&writer, t]() {
+                RecordWriter::Buffer buffer(writer);
+                for (int g = 0; g < 500; ++g)
+                    buffer.add(record(t * 500 + g));
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        ASSERT_TRUE(writer.close());
+
+        RecordReader reader;
+        ASSERT_TRUE(reader.open(path));
+        ASSERT_THAT(reader.size(), Eq(2000u));
+
+        std::vector<bool> seen(2000);
+        while (const GameRecord* r = reader.next())
+        {
+            int g = r->iterations / std::max<int>(1, r->n_plies);
+            ASSERT_THAT(g, Lt(2000));
+            EXPECT_FALSE(seen[g]);
+            EXPECT_TRUE(same(*r, record(g)));
+            seen[g] = true;
+        }
+    }
+
+    TEST_F(RecordsTest, InvalidFileIsRejected)
+    {
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            ofs << "not a file of records, not at all";
+        }
+
+        RecordReader reader;
+        EXPECT_FALSE(reader.open(path));
+        EXPECT_FALSE(reader.open(path + ".missing"));
+        EXPECT_FALSE(reader.is_open());
+    }
+
+    // The searches of a game of the agent against itself, as recorded.
+    TEST_F(RecordsTest, AgentGame)
+    {
+        Agent::debug_counters = false;
+        Agent::use_time = false;
+        Agent::set_max_iter(200);
+        MCTS.clear();
+
+        GameRecord r;
+        State state;
+        std::array<StateData, 10> sd;
+        Agent agent(state);
+
+        for (int i = 0; !state.is_terminal(); ++i)
+        {
+            Move move = agent.MCTSBestMove();
+            r.add(move, agent.info());
+            state.apply_move(move, sd[i]);
+        }
+        r.winner = state.winner();
+        MCTS.clear();
+
+        EXPECT_THAT(r.n_plies, AllOf(Ge(5), Le(9)));
+        EXPECT_THAT(r.iterations, Gt(0u));
+        for (int p = 0; p < r.n_plies; ++p)
+            EXPECT_THAT(r.plies[p].visits[r.plies[p].cell], Gt(0));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
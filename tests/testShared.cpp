@@ -0,0 +1,219 @@
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "evaluator.h"
+#include "mcts.h"
+#include "shared.h"
+
+namespace mcts {
+namespace {
+
+    class SharedTableTest : public ::testing::Test {
+    protected:
+        SharedTableTest()
+        {
+            SharedTable::unlink(name);
+            MCTS.clear();
+            Agent::debug_counters = false;
+        }
+
+        ~SharedTableTest()
+        {
+            Agent::shared_table = nullptr;
+            Agent::evaluator = nullptr;
+            Agent::batch_size = 16;
+            Agent::set_max_iter(1000);
+            SharedTable::unlink(name);
+        }
+
+        // Runs `work` in n forked processes and waits for all of them,
+        // returns the number of processes which exited with 0.
+        template<class F>
+        int in_processes(int n, F work)
+        {
+            std::vector<pid_t> pids;
+            for (int i = 0; i < n; ++i)
+            {
+                pid_t pid = fork();
+                if (pid == 0)
+                    _exit(work(i));
+                pids.push_back(pid);
+            }
+
+            int succeeded = 0;
+            for (pid_t pid : pids)
+            {
+                int status = 0;
+                waitpid(pid, &status, 0);
+                succeeded += WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            }
+            return succeeded;
+        }
+
+        std::string name = "/testSharedTable." + std::to_string(getpid());
+    };
+
+    using namespace ::testing;
+
+    TEST_F(SharedTableTest, UpdatesAreSeenThroughAnotherMapping)
+    {
+        SharedTable a, b;
+        ASSERT_TRUE(a.open(name, 1000));
+        ASSERT_TRUE(b.open(name));
+        EXPECT_THAT(b.capacity(), Eq(1024u));
+
+        State state;
+        Agent agent(state);
+        Node node = MCTS[state.key()];
+        Move move = node.children[0].move;
+
+        a.add(node.key, move, 3, 2.0, 1.5);
+
+        ASSERT_TRUE(b.load(node));
+        EXPECT_THAT(node.children[0].n_visits, Eq(3));
+        EXPECT_THAT(node.children[0].action_value, DoubleEq(2.0));
+        EXPECT_THAT(node.children[0].avg_action_value, DoubleEq(2.0 / 3));
+        EXPECT_THAT(b.size(), Eq(1u));
+    }
+
+    // The virtual visits of the batched search aren't in the segment, they are kept.
+    TEST_F(SharedTableTest, PendingVisitsStayOnTopOfTheShared)
+    {
+        SharedTable table;
+        ASSERT_TRUE(table.open(name, 1000));
+
+        State state;
+        Agent agent(state);
+        Node node = MCTS[state.key()];
+        node.children[0].n_visits  = 2;
+        node.children[0].n_pending = 2;
+
+        table.add(node.key, node.children[0].move, 3, 2.0, 1.5);
+
+        ASSERT_TRUE(table.load(node));
+        EXPECT_THAT(node.children[0].n_visits, Eq(5));
+        EXPECT_THAT(node.children[0].action_value, DoubleEq(2.0));
+        EXPECT_THAT(node.children[0].avg_action_value, DoubleEq(2.0 / 5));
+    }
+
+    // The descents of a batch still spread out over the root's children, and
+    // the segment ends up with the real visits only.
+    TEST_F(SharedTableTest, BatchedSearchKeepsItsVirtualVisits)
+    {
+        // The first batch is the root alone, the second one its descents.
+        struct SecondBatch : HeuristicEvaluator {
+            void evaluate(const std::vector<Leaf>& leaves, std::vector<Evaluation>& out) override {
+                if (++n_batches == 2)
+                    size = leaves.size();
+                HeuristicEvaluator::evaluate(leaves, out);
+            }
+            int n_batches = 0;
+            size_t size = 0;
+        } evaluator;
+
+        SharedTable table;
+        ASSERT_TRUE(table.open(name));
+        Agent::shared_table = &table;
+        Agent::evaluator = &evaluator;
+        Agent::batch_size = 16;
+        Agent::set_max_iter(200);
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        EXPECT_THAT(evaluator.size, Eq(9u));
+
+        Node root = MCTS[state.key()];
+        int visits = 0;
+        for (int i = 0; i < root.n_children; ++i)
+            EXPECT_THAT(root.children[i].n_pending, Eq(0));
+
+        ASSERT_TRUE(table.load(root));
+        for (int i = 0; i < root.n_children; ++i)
+            visits += root.children[i].n_visits;
+        EXPECT_THAT(visits, Eq(200));
+    }
+
+    TEST_F(SharedTableTest, ConcurrentAddsFromProcessesAreNotLost)
+    {
+        SharedTable table;
+        ASSERT_TRUE(table.open(name));
+
+        const int n_procs = 4, n_adds = 20000;
+        int ok = in_processes(n_procs, [&](int i) {
+            SharedTable t;
+            if (!t.open(name))
+                return 1;
+            for (int j = 0; j < n_adds; ++j)
+                t.add(Key(8 * (j % 16)), Move(1 + j % 9), 1, 0.5, 0.25);
+            return 0;
+        });
+        ASSERT_THAT(ok, Eq(n_procs));
+
+        Node node;
+        node.n_children = 9;
+        for (int m = 0; m < 9; ++m)
+        {
+            node.children[m].move      = Move(1 + m);
+            node.children[m].n_pending = 0;
+        }
+
+        int visits = 0;
+        double value = 0;
+        for (int k = 0; k < 16; ++k)
+        {
+            node.key = Key(8 * k);
+            ASSERT_TRUE(table.load(node));
+            for (int m = 0; m < 9; ++m)
+            {
+                visits += node.children[m].n_visits;
+                value  += node.children[m].action_value;
+            }
+        }
+        EXPECT_THAT(visits, Eq(n_procs * n_adds));
+        EXPECT_THAT(value, DoubleEq(0.5 * n_procs * n_adds));
+    }
+
+    TEST_F(SharedTableTest, ProcessesSearchTogether)
+    {
+        SharedTable table;
+        ASSERT_TRUE(table.open(name));
+
+        const int n_procs = 3, n_iter = 300;
+        int ok = in_processes(n_procs, [&](int) {
+            SharedTable t;
+            if (!t.open(name))
+                return 1;
+            MCTS.clear();
+            Agent::shared_table = &t;
+            Agent::set_max_iter(n_iter);
+
+            State state;
+            Agent agent(state);
+            return agent.MCTSBestMove() == MOVE_NONE ? 1 : 0;
+        });
+        ASSERT_THAT(ok, Eq(n_procs));
+
+        // Every iteration goes through one edge of the root.
+        State state;
+        Agent agent(state);
+        Node root = MCTS[state.key()];
+        ASSERT_TRUE(table.load(root));
+
+        int visits = 0;
+        for (int i = 0; i < root.n_children; ++i)
+            visits += root.children[i].n_visits;
+        EXPECT_THAT(visits, Eq(n_procs * n_iter));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
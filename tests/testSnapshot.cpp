@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "snapshot.h"
+
+namespace mcts {
+namespace {
+
+    class SnapshotTest : public ::testing::Test {
+    protected:
+        SnapshotTest()
+        {
+            MCTS.clear();
+            Agent::debug_counters = false;
+            Agent::set_max_iter(200);
+        }
+
+        ~SnapshotTest()
+        {
+            Agent::warm_start = nullptr;
+            std::remove(path.c_str());
+        }
+
+        std::string path = "testSnapshot.snap";
+    };
+
+    using namespace ::testing;
+
+    TEST_F(SnapshotTest, SavedNodesAreFoundAfterMapping)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+
+        Node root = MCTS[state.key()];
+        ASSERT_TRUE(Snapshot::save(path));
+
+        Snapshot snapshot;
+        ASSERT_TRUE(snapshot.open(path));
+
+        const auto* rec = snapshot.find(state.key());
+        ASSERT_THAT(rec, NotNull());
+
+        Node copy;
+        Snapshot::to_node(*rec, copy);
+        EXPECT_THAT(copy.n_visits, Eq(root.n_visits));
+        EXPECT_THAT(copy.n_children, Eq(root.n_children));
+        for (int i = 0; i < root.n_children; ++i)
+        {
+            EXPECT_THAT(copy.children[i].move, Eq(root.children[i].move));
+            EXPECT_THAT(copy.children[i].n_visits, Eq(root.children[i].n_visits));
+            EXPECT_THAT(copy.children[i].action_value, DoubleEq(root.children[i].action_value));
+        }
+    }
+
+    TEST_F(SnapshotTest, WarmStartSeedsNewNodes)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        int visits = MCTS[state.key()].n_visits;
+
+        ASSERT_TRUE(Snapshot::save(path));
+        MCTS.clear();
+
+        Snapshot snapshot;
+        ASSERT_TRUE(snapshot.open(path));
+        Agent::warm_start = &snapshot;
+
+        Agent warm_agent(state);
+        EXPECT_THAT(MCTS[state.key()].n_visits, Eq(visits));
+    }
+
+    // The nodes moved to the arena are saved along with the table's.
+    TEST_F(SnapshotTest, CompactedTreeIsSaved)
+    {
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        ASSERT_THAT(agent.compact(), Gt(1u));
+
+        size_t n_expanded = 0;
+        for (const auto& [key, node] : MCTS)
+            n_expanded += node.n_visits > 0;
+        for (const auto& node : game_arena<State>.nodes)
+            n_expanded += node.n_visits > 0;
+
+        ASSERT_TRUE(Snapshot::save(path));
+        Agent::clear_table();
+
+        Snapshot snapshot;
+        ASSERT_TRUE(snapshot.open(path));
+        EXPECT_THAT(snapshot.size(), Eq(n_expanded));
+        EXPECT_THAT(snapshot.find(state.key()), NotNull());
+    }
+
+    // As are the nodes of the direct table.
+    TEST_F(SnapshotTest, DirectTableIsSaved)
+    {
+        Agent::direct_table = true;
+
+        State state;
+        Agent agent(state);
+        agent.MCTSBestMove();
+        ASSERT_TRUE(Agent::uses_direct_table());
+
+        size_t n_expanded = 0;
+        for (const auto& node : direct_nodes<State>)
+            n_expanded += node.n_visits > 0;
+        ASSERT_THAT(n_expanded, Gt(1u));
+
+        ASSERT_TRUE(Snapshot::save(path));
+        Agent::clear_table();
+        Agent::direct_table = false;
+
+        Snapshot snapshot;
+        ASSERT_TRUE(snapshot.open(path));
+        EXPECT_THAT(snapshot.size(), Eq(n_expanded));
+        EXPECT_THAT(snapshot.find(state.key()), NotNull());
+    }
+
+    TEST_F(SnapshotTest, OpenRejectsInvalidFiles)
+    {
+        std::ofstream(path) << "not a snapshot";
+
+        Snapshot snapshot;
+        EXPECT_FALSE(snapshot.open(path));
+        EXPECT_FALSE(snapshot.open("does/not/exist"));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
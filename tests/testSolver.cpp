@@ -0,0 +1,126 @@
+#include <array>
+#include <cstdio>
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "solver.h"
+
+namespace mcts {
+namespace {
+
+    class SolverTest : public ::testing::Test {
+    protected:
+        static void SetUpTestSuite()
+        {
+            table.solve(2);
+        }
+
+        using V = std::vector<int>;
+        State CreateState(V Xs, V Os)
+        {
+            State state {};
+            int i = 0;
+            for (size_t n = 0; n < Xs.size(); ++n)
+            {
+                state.apply_move(Move(1 + Xs[n]), sd[i++]);
+                if (n < Os.size())
+                    state.apply_move(Move(10 + Os[n]), sd[i++]);
+            }
+            return state;
+        }
+
+        static inline Solver::Table table;
+        std::array<StateData, 9> sd;
+    };
+
+    using namespace ::testing;
+
+    TEST_F(SolverTest, IndexIsBase3EncodingOfTheGrid)
+    {
+        State state = CreateState({ 0 }, { 2 });
+        EXPECT_THAT(State::index(state.grid()), Eq(1 * 1 + 2 * 9));
+        EXPECT_THAT(State::index(state.grid()), Eq(state.index()));
+    }
+
+    TEST_F(SolverTest, AllReachablePositionsAreSolved)
+    {
+        int reachable = 0;
+        for (int i = 0; i < Solver::N_POSITIONS; ++i)
+            reachable += table.value(i) != Solver::VALUE_NONE;
+
+        ASSERT_THAT(reachable, Eq(5478));
+    }
+
+    TEST_F(SolverTest, EmptyBoardIsADraw)
+    {
+        State state {};
+        ASSERT_THAT(table.value(state), Eq(Solver::VALUE_DRAW));
+    }
+
+    TEST_F(SolverTest, FindsTheWinningMove)
+    {
+        // XX*
+        // OO*
+        // ***
+        State state = CreateState({ 0, 1 }, { 3, 4 });
+
+        EXPECT_THAT(table.value(state), Eq(Solver::VALUE_WIN));
+        EXPECT_THAT(table.best_move(state), Eq(Move(3)));
+        EXPECT_THAT(table.reward(state, Move(3)), DoubleEq(1.0));
+        EXPECT_FALSE(table.is_perfect(state, Move(9)));
+    }
+
+    // The agent playing the table's moves reports them as any search would, not
+    // what its previous search found.
+    TEST_F(SolverTest, PerfectMovesArePublished)
+    {
+        Agent::debug_counters = false;
+        Agent::use_time = false;
+        Agent::set_max_iter(200);
+        MCTS.clear();
+
+        State state = CreateState({ 0, 1 }, { 3, 4 });
+        Agent agent(state);
+        agent.MCTSBestMove();
+        ASSERT_THAT(agent.info().iterations, Gt(0));
+
+        Agent::perfect_table = &table;
+        Agent::perfect_moves = true;
+        Move move = agent.MCTSBestMove();
+        SearchInfo si = agent.info();
+        Agent::perfect_table = nullptr;
+        Agent::perfect_moves = false;
+
+        EXPECT_THAT(move, Eq(Move(3)));
+        EXPECT_THAT(agent.best_so_far(), Eq(move));
+        EXPECT_THAT(si.best_move, Eq(move));
+        EXPECT_THAT(si.iterations, Eq(0));
+        EXPECT_THAT(si.pv, ElementsAre(move));
+        EXPECT_THAT(si.root_visits, IsEmpty());
+
+        Agent::set_max_iter(1000);
+        MCTS.clear();
+    }
+
+    TEST_F(SolverTest, MappedTableMatchesSolvedTable)
+    {
+        std::string path = "testSolver.table";
+        ASSERT_TRUE(table.save(path));
+
+        Solver::Table mapped;
+        ASSERT_TRUE(mapped.open(path));
+        for (int i = 0; i < Solver::N_POSITIONS; ++i)
+            ASSERT_THAT(mapped.value(i), Eq(table.value(i)));
+
+        std::remove(path.c_str());
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -176,7 +176,7 @@ namespace {
 
     TEST_F(StateTest, EmptyCellsFullOnInitialState)
     {
-        std::list<Cell> expected;
+        std::vector<Cell> expected;
         for (int i = 0; i < 9; ++i) {
             expected.push_back(Cell(i));
         }
@@ -187,7 +187,7 @@ namespace {
     TEST_F(StateTest, EmptyCellsCorrectlyInitializedWithCreateState)
     {
         State state = CreateState({ 0, 4, 7 }, { 2, 5 });
-        std::list<Cell> expected;
+        std::vector<Cell> expected;
         std::vector<int> expected_ndx { { 1, 3, 6, 8 } };
         for (auto ndx : expected_ndx) {
             expected.push_back(Cell(ndx));
@@ -200,7 +200,7 @@ namespace {
     {
         initialState.apply_move(Move(5), sd[0]);
         initialState.apply_move(Move(15), sd[1]);
-        std::list<Cell> expected;
+        std::vector<Cell> expected;
         std::vector<int> expected_ndx { { 0, 1, 2, 3, 6, 7, 8 } };
         for (auto ndx : expected_ndx) {
             expected.push_back(Cell(ndx));
@@ -314,6 +314,96 @@ namespace {
         EXPECT_THAT(key_winner(state1.key()), TOK_EMPTY);
      }
 
+    // The status bits read back by key_terminal() and key_winner().
+    TEST_F(StateTest, StatusBitsMatchTheKeyReaders)
+    {
+        EXPECT_THAT(status_bits(false, false), Eq(0u));
+        EXPECT_TRUE(key_terminal(status_bits(true, false)));
+        EXPECT_TRUE(key_terminal(status_bits(true, true)));     // A win on the last move isn't a draw.
+        EXPECT_THAT(key_winner(status_bits(true, true)), Ne(TOK_EMPTY));
+        EXPECT_TRUE(key_terminal(status_bits(false, true)));
+        EXPECT_THAT(key_winner(status_bits(false, true)), Eq(TOK_EMPTY));
+    }
+
+    TEST_F(StateTest, ZobristKeysAreKnownAtCompileTime)
+    {
+        static_assert(Zobrist::ndx_keys[0] == 0);
+        static_assert(Zobrist::make_keys(1070372) == Zobrist::ndx_keys);
+        static_assert((Zobrist::moveKey(Move(5)) & 7) == 0);
+
+        initialState.apply_move(Move(5), sd[0]);
+
+        EXPECT_THAT(initialState.key(), Eq(Zobrist::moveKey(Move(5)) ^ Zobrist::sideKey));
+    }
+
+    TEST_F(StateTest, KeyAfterMatchesKeyOfAppliedMove)
+    {
+        // XX*   XOX   XXO
+        // OO*   OXO   OOX
+        // ***   *X*   XO*
+        State state1 = CreateState({ 0, 1 }, { 3, 4 });
+        State state2 = CreateState({ 0, 2, 4, 7 }, { 1, 3, 5 });
+        State state3 = CreateState({ 0, 1, 5, 6 }, { 2, 3, 4, 7 });
+
+        for (State* state : { &state1, &state2, &state3 })
+        {
+            for (Move move : std::vector<Move>(state->valid_actions()))
+            {
+                StateData child;
+                Key expected_key = state->key_after(move);
+
+                state->apply_move(move, child);
+                EXPECT_THAT(state->key(), Eq(expected_key));
+                state->undo_move(move);
+            }
+        }
+    }
+
+    TEST_F(StateTest, IndexIsKeptUpToDate)
+    {
+        State state = CreateState({ 0, 4 }, { 2 });
+        EXPECT_THAT(state.index(), Eq(1 * 1 + 2 * 9 + 1 * 81));
+
+        Move move = State::cellTokenToMove(Cell(8), O);
+        int expected = state.index_after(move);
+        StateData child;
+
+        state.apply_move(move, child);
+        EXPECT_THAT(state.index(), Eq(expected));
+        EXPECT_THAT(expected, Eq(1 + 18 + 81 + 2 * 6561));
+
+        state.undo_move(move);
+        EXPECT_THAT(state.index(), Eq(1 + 18 + 81));
+    }
+
+    // The index is exact: one index per position, so one key per index.
+    TEST_F(StateTest, IndexIdentifiesThePositions)
+    {
+        std::vector<Key> keys(State::INDEX_SIZE, Key(~0));
+        int n_positions = 0;
+        State state;
+
+        auto visit = [&](auto& self, int depth) -> void {
+            Key& k = keys[state.index()];
+            if (k == Key(~0))
+            {
+                k = state.key();
+                ++n_positions;
+            }
+            ASSERT_THAT(k, Eq(state.key()));
+
+            for (Move m : std::vector<Move>(state.valid_actions()))
+            {
+                state.apply_move(m, sd[depth]);
+                self(self, depth + 1);
+                state.undo_move(m);
+            }
+        };
+        visit(visit, 0);
+
+        EXPECT_THAT(n_positions, Eq(5478));
+    }
+
 } // namespace
 } // namespace mcts
 
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcts.h"
+#include "trace.h"
+
+namespace mcts {
+namespace {
+
+    using namespace ::testing;
+
+    using Trace::Event;
+
+    TEST(TraceTest, RingKeepsTheLastEvents)
+    {
+        Trace::Ring ring(6);
+        ASSERT_THAT(ring.capacity(), Eq(8u));
+
+        for (int i = 0; i < 11; ++i)
+            ring.record(Trace::EVENT_ITERATION, i, 0);
+
+        auto events = ring.events();
+        ASSERT_THAT(events.size(), Eq(8u));
+        EXPECT_THAT(events.front().iteration, Eq(3u));
+        EXPECT_THAT(events.back().iteration, Eq(10u));
+        EXPECT_THAT(events.back().time_ns, Ge(events.front().time_ns));
+    }
+
+    TEST(TraceTest, FlushedTraceReadsBack)
+    {
+        Trace::Ring ring(4);
+        ring.record(Trace::EVENT_SELECT, 1, 2, Move(7), 3);
+        for (int i = 0; i < 4; ++i)
+            ring.record(Trace::EVENT_ROLLOUT, 2, 5, MOVE_NONE, 0, 0.25f * i);
+
+        std::string path = ::testing::TempDir() + "mcts.trace";
+        ASSERT_TRUE(ring.flush(path));
+
+        std::vector<Event> events;
+        Trace::Header header;
+        ASSERT_TRUE(Trace::load(path, events, &header));
+        std::remove(path.c_str());
+
+        EXPECT_THAT(header.n_dropped, Eq(1u));
+        ASSERT_THAT(events.size(), Eq(4u));
+        EXPECT_THAT(events[3].type, Eq(Trace::EVENT_ROLLOUT));
+        EXPECT_THAT(events[3].depth, Eq(5));
+        EXPECT_THAT(events[3].value, FloatEq(0.75f));
+    }
+
+    // The events of a traced search go search, (iteration, select..., leaf, rollout,
+    // backup) for each iteration, then result.
+    TEST(TraceTest, SearchEventsFollowTheIterations)
+    {
+        Agent::debug_counters = false;
+        Agent::trace_search = true;
+        MCTS.clear();
+        Trace::ring().clear();
+
+        State state;
+        Agent agent(state);
+        Move move = agent.MCTSBestMove();
+
+        Agent::trace_search = false;
+        auto events = Trace::ring().events();
+
+        ASSERT_THAT(events.size(), Gt(2u));
+        EXPECT_THAT(events.front().type, Eq(Trace::EVENT_SEARCH));
+        EXPECT_THAT(events.back().type, Eq(Trace::EVENT_RESULT));
+        EXPECT_THAT(events.back().move, Eq(move));
+
+        int n_iterations = 0, n_selects = 0;
+        for (size_t i = 1; i + 1 < events.size(); ++i)
+        {
+            const Event& e = events[i];
+            switch (e.type)
+            {
+                case Trace::EVENT_ITERATION:
+                    EXPECT_THAT(e.iteration, Eq(uint32_t(n_iterations)));
+                    n_selects = 0;
+                    break;
+                case Trace::EVENT_SELECT:
+                    EXPECT_THAT(e.depth, Eq(n_selects++));
+                    break;
+                case Trace::EVENT_LEAF:
+                    EXPECT_THAT(e.depth, Eq(n_selects));
+                    break;
+                case Trace::EVENT_ROLLOUT:
+                    EXPECT_THAT(e.value, AllOf(Ge(0), Le(1)));
+                    break;
+                case Trace::EVENT_BACKUP:
+                    ++n_iterations;
+                    break;
+                default:
+                    ADD_FAILURE() << "Unexpected event " << int(e.type);
+            }
+        }
+        EXPECT_THAT(n_iterations, Eq(Agent::MAX_ITER));
+
+        MCTS.clear();
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "solver.h"
+#include "tuner.h"
+
+namespace mcts {
+namespace {
+
+    class TunerTest : public ::testing::Test {
+    protected:
+        static void SetUpTestSuite()
+        {
+            table.solve(2);
+        }
+
+        TunerTest() : saved(Tuner::current())
+        {
+            Agent::debug_counters = false;
+        }
+
+        ~TunerTest()
+        {
+            Tuner::apply(saved);
+            Agent::perfect_table = nullptr;
+            Agent::perfect_moves = false;
+            Agent::use_time = false;
+            Agent::set_max_iter(1000);
+            Agent::clear_table();
+        }
+
+        static inline Solver::Table table;
+        Tuner::Params saved;
+    };
+
+    using namespace ::testing;
+
+    TEST_F(TunerTest, PointsMapBackToTheirKnobs)
+    {
+        Tuner::Params p;
+        p.exploration_cst   = 1.3;
+        p.propagate_minimax = true;
+        p.n_rollouts        = 5;
+
+        Tuner::Point u = Tuner::to_point(p);
+        Tuner::Params q = Tuner::to_params(u);
+        EXPECT_THAT(q.exploration_cst, DoubleNear(p.exploration_cst, 1e-12));
+        EXPECT_THAT(q.propagate_minimax, Eq(p.propagate_minimax));
+        EXPECT_THAT(q.n_rollouts, Eq(p.n_rollouts));
+        EXPECT_THAT(Tuner::to_point(q), Pointwise(DoubleNear(1e-12), u));
+    }
+
+    TEST_F(TunerTest, KnobsOutOfRangeAreClamped)
+    {
+        Tuner::Params high;
+        high.exploration_cst = 10;
+        high.n_rollouts      = 100;
+        EXPECT_THAT(Tuner::to_point(high), ElementsAre(1.0, 0.25, 1.0));
+
+        Tuner::Params low;
+        low.exploration_cst = -1;
+        low.n_rollouts      = 0;
+        EXPECT_THAT(Tuner::to_point(low), ElementsAre(0.0, 0.25, 0.0));
+
+        Tuner::Params p = Tuner::to_params(Tuner::to_point(high));
+        EXPECT_THAT(p.exploration_cst, DoubleEq(Tuner::EXP_C_MAX));
+        EXPECT_THAT(p.n_rollouts, Eq(Tuner::ROLLOUTS_MAX));
+
+        p = Tuner::to_params(Tuner::to_point(low));
+        EXPECT_THAT(p.exploration_cst, DoubleEq(Tuner::EXP_C_MIN));
+        EXPECT_THAT(p.n_rollouts, Eq(1));
+    }
+
+    // With the perfect table's moves, every budget plays perfectly: the first one is
+    // the cheapest, and SPSA has nothing to improve on its starting point.
+    TEST_F(TunerTest, CheapestBudgetIsTheFirstWithoutFailures)
+    {
+        Agent::perfect_table = &table;
+        Agent::perfect_moves = true;
+
+        Tuner::Config config;
+        config.n_steps        = 2;
+        config.games_per_eval = 3;
+        config.seed           = 7;
+
+        Tuner::Params start;
+        start.exploration_cst = 0.9;
+        EXPECT_THAT(Tuner::evaluate(start, config, 11), Eq(0.0));
+
+        Tuner::Params best;
+        EXPECT_THAT(Tuner::cheapest_budget({ 5, 50, 500 }, start, best, config), Eq(5));
+        EXPECT_THAT(best.exploration_cst, DoubleNear(start.exploration_cst, 1e-12));
+        EXPECT_THAT(best.n_rollouts, Eq(start.n_rollouts));
+        EXPECT_THAT(Agent::exploration_cst, DoubleNear(start.exploration_cst, 1e-12));
+    }
+
+} // namespace
+} // namespace mcts
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,92 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "connectfour.h"
+#include "mcts.h"
+
+using namespace mcts;
+
+using C4Agent = GameAgent<ConnectFour>;
+
+void usage()
+{
+    std::cerr << "Usage: connectfour [options]\n"
+              << "  --games N        Self-play games (default 4)\n"
+              << "  --iter N         Iterations per move (default 20000)\n"
+              << "  --max-bytes N    Memory budget of the table (default none)\n"
+              << "  --keep           Keep the table between the games" << std::endl;
+}
+
+// Self-play games, the scaling benchmark of the search: deep trees and a table
+// growing to millions of nodes. One line per game, then the totals.
+int main(int argc, char* argv[])
+{
+    int n_games = 4;
+    bool keep = false;
+    C4Agent::set_max_iter(20000);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "--games")          n_games = std::atoi(next().c_str());
+        else if (arg == "--iter")      C4Agent::set_max_iter(std::atoi(next().c_str()));
+        else if (arg == "--max-bytes") C4Agent::max_bytes = std::atoll(next().c_str());
+        else if (arg == "--keep")      keep = true;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    C4Agent::debug_counters = false;
+    C4Agent::use_time = false;
+
+    auto& table = game_table<ConnectFour>;
+    std::chrono::steady_clock::duration total {};
+    long long total_moves = 0;
+
+    std::cout << "game plies winner ms_per_move nodes table_bytes evicted" << std::endl;
+    for (int g = 0; g < n_games; ++g)
+    {
+        if (!keep)
+            table.clear();
+
+        ConnectFour state;
+        std::array<StateData, ConnectFour::MAX_GAME_PLY + 1> sd;
+        C4Agent agent(state);
+        std::chrono::steady_clock::duration thinking {};
+        int evicted = 0;
+
+        for (int i = 0; !state.is_terminal(); ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Move move = agent.MCTSBestMove();
+            thinking += std::chrono::steady_clock::now() - start;
+            evicted += agent.evictions();
+
+            state.apply_move(move, sd[i]);
+        }
+
+        int plies = state.gamePly - 1;
+        double ms = std::chrono::duration_cast<std::chrono::microseconds>(thinking).count() / 1000.0;
+        Token winner = state.winner();
+
+        std::cout << g << ' ' << plies << ' ' << (winner == X ? "X" : winner == O ? "O" : "draw")
+                  << ' ' << ms / plies << ' ' << table.size() << ' ' << C4Agent::table_bytes()
+                  << ' ' << evicted << std::endl;
+
+        total += thinking;
+        total_moves += plies;
+    }
+
+    double us = std::chrono::duration_cast<std::chrono::microseconds>(total).count();
+    if (total_moves)
+        std::cout << "# iterations/s " << 1e6 * total_moves * C4Agent::MAX_ITER / us << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mcts.h"
+#include "solver.h"
+
+using namespace mcts;
+
+struct Measure {
+    double perfect_rate;
+    double us_per_move;
+};
+
+// Games against a random opponent (the agent alternates sides), timing the agent's
+// moves and checking them against the perfect play table.
+Measure measure(const Solver::Table& table, int n_games, std::mt19937& rng)
+{
+    int perfect = 0, total = 0;
+    std::chrono::steady_clock::duration thinking {};
+
+    for (int g = 0; g < n_games; ++g)
+    {
+        MCTS.clear();
+
+        State state;
+        std::array<StateData, 10> sd;
+        Agent agent(state);
+        Token side = g & 1 ? O : X;
+
+        for (int i = 0; !state.is_terminal(); ++i)
+        {
+            Move move;
+            if (state.next_player() == side)
+            {
+                auto start = std::chrono::steady_clock::now();
+                move = agent.MCTSBestMove();
+                thinking += std::chrono::steady_clock::now() - start;
+
+                perfect += table.is_perfect(state, move);
+                ++total;
+            }
+            else
+            {
+                auto& moves = state.valid_actions();
+                move = moves[rng() % moves.size()];
+            }
+            state.apply_move(move, sd[i]);
+        }
+    }
+
+    double us = std::chrono::duration_cast<std::chrono::microseconds>(thinking).count();
+
+    return { total ? double(perfect) / total : 1.0, total ? us / total : 0.0 };
+}
+
+std::vector<int> parse_list(const std::string& list)
+{
+    std::vector<int> values;
+    std::istringstream ss(list);
+    for (std::string v; std::getline(ss, v, ',');)
+        values.push_back(std::atoi(v.c_str()));
+
+    return values;
+}
+
+void usage()
+{
+    std::cerr << "Usage: playouts [options]\n"
+              << "  --playouts a,b,..  Playouts per leaf to compare (default 0,1,2,4,8,16)\n"
+              << "  --budgets a,b,..   Iteration budgets per move (default 25,50,100,200,400)\n"
+              << "  --decay N          Playouts dropped per ply below the root (default 0)\n"
+              << "  --simd             Batched playouts (see playout.h)\n"
+              << "  --games N          Games per measure (default 200)\n"
+              << "  --seed N           Seed of the random opponent" << std::endl;
+}
+
+// Prints one line per (playouts, budget) pair, so that the perfect move rate can be
+// plotted against the thinking time for each number of playouts.
+int main(int argc, char* argv[])
+{
+    std::vector<int> playouts = { 0, 1, 2, 4, 8, 16 };
+    std::vector<int> budgets  = { 25, 50, 100, 200, 400 };
+    int n_games = 200;
+    unsigned seed = std::random_device{}();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "--playouts")     playouts = parse_list(next());
+        else if (arg == "--budgets") budgets = parse_list(next());
+        else if (arg == "--decay")   Agent::playouts_decay = std::atoi(next().c_str());
+        else if (arg == "--simd")    Agent::simd_playouts = true;
+        else if (arg == "--games")   n_games = std::atoi(next().c_str());
+        else if (arg == "--seed")    seed = std::atoi(next().c_str());
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    Solver::Table table;
+    table.solve();
+
+    Agent::debug_counters = false;
+    Agent::use_time = false;
+
+    std::cout << "playouts budget us_per_move perfect_rate" << std::endl;
+    for (int k : playouts)
+    {
+        Agent::leaf_playouts = k;
+        for (int budget : budgets)
+        {
+            Agent::set_max_iter(budget);
+
+            std::mt19937 rng(seed);    // The same opponent's moves for every measure.
+            Measure m = measure(table, n_games, rng);
+
+            std::cout << k << ' ' << budget << ' ' << m.us_per_move << ' ' << m.perfect_rate << std::endl;
+        }
+    }
+
+    return 0;
+}
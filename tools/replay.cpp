@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+using namespace mcts;
+using Trace::Event;
+
+// An iteration rebuilt from its events.
+struct Iteration {
+    uint32_t            number = 0;
+    std::vector<Event>  path;            // The EVENT_SELECT ones.
+    int                 leaf_depth = 0;
+    float               value = 0;
+    uint64_t            start = 0, leaf = 0, rollout = 0, backup = 0;
+
+    bool complete() const { return start && leaf && rollout && backup; }
+};
+
+struct Search {
+    uint64_t                start = 0, end = 0;
+    int                     root_visits = 0;
+    int                     move = 0;
+    std::vector<Iteration>  iterations;
+};
+
+// Groups the events by search and by iteration. A search whose start was overwritten
+// in the ring starts at its first iteration left.
+std::vector<Search> rebuild(const std::vector<Event>& events)
+{
+    std::vector<Search> searches;
+    Iteration* it = nullptr;
+
+    auto current = [&]() -> Search& {
+        if (searches.empty())
+            searches.emplace_back();
+        return searches.back();
+    };
+
+    for (const auto& e : events)
+    {
+        switch (e.type)
+        {
+            case Trace::EVENT_SEARCH:
+                searches.emplace_back();
+                searches.back().start = e.time_ns;
+                searches.back().root_visits = e.value;
+                it = nullptr;
+                break;
+
+            case Trace::EVENT_ITERATION:
+                current().iterations.emplace_back();
+                it = &current().iterations.back();
+                it->number = e.iteration;
+                it->start = e.time_ns;
+                break;
+
+            case Trace::EVENT_SELECT:
+                if (it) it->path.push_back(e);
+                break;
+
+            case Trace::EVENT_LEAF:
+                if (it) { it->leaf = e.time_ns; it->leaf_depth = e.depth; }
+                break;
+
+            case Trace::EVENT_ROLLOUT:
+                if (it) { it->rollout = e.time_ns; it->value = e.value; }
+                break;
+
+            case Trace::EVENT_BACKUP:
+                if (it) it->backup = e.time_ns;
+                it = nullptr;
+                break;
+
+            case Trace::EVENT_RESULT:
+                current().end = e.time_ns;
+                current().move = e.move;
+                it = nullptr;
+                break;
+        }
+    }
+    return searches;
+}
+
+void print_latencies(const char* name, std::vector<uint64_t>& ns)
+{
+    if (ns.empty())
+        return;
+
+    std::sort(ns.begin(), ns.end());
+    double mean = 0;
+    for (auto v : ns)
+        mean += v;
+    mean /= ns.size();
+
+    auto pct = [&](double p) { return ns[std::min(ns.size() - 1, size_t(p * ns.size()))]; };
+
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(0) << mean
+              << std::setw(10) << pct(0.5) << std::setw(10) << pct(0.99) << std::setw(10) << ns.back() << '\n';
+}
+
+void print_search(const Search& s, int index, int n_paths, bool values)
+{
+    std::cout << "\nSearch " << index << ": " << s.iterations.size() << " iterations";
+    if (s.start && s.end)
+        std::cout << " in " << (s.end - s.start) / 1000 << " us";
+    if (s.move)
+        std::cout << ", played " << s.move;
+    std::cout << ", root had " << s.root_visits << " visits\n";
+
+    // How the descents split between the root's edges, and how deep they went.
+    std::map<int, int> root_edges, depths;
+    for (const auto& it : s.iterations)
+    {
+        if (!it.path.empty())
+            ++root_edges[it.path[0].move];
+        ++depths[it.leaf_depth];
+    }
+
+    std::cout << "  root edges:";
+    for (auto [move, n] : root_edges)
+        std::cout << ' ' << move << ':' << n;
+    std::cout << "\n  leaf depths:";
+    for (auto [d, n] : depths)
+        std::cout << ' ' << d << ':' << n;
+    std::cout << '\n';
+
+    for (int i = 0; i < n_paths && i < (int)s.iterations.size(); ++i)
+    {
+        const auto& it = s.iterations[i];
+        std::cout << "  " << std::setw(6) << it.number << ':';
+        for (const auto& e : it.path)
+            std::cout << ' ' << e.move << '#' << int(e.edge);
+        std::cout << "  -> " << std::setprecision(3) << it.value << '\n';
+    }
+
+    // The rollout values and their running mean, to plot.
+    if (values)
+    {
+        double sum = 0;
+        int n = 0;
+        for (const auto& it : s.iterations)
+        {
+            sum += it.value;
+            std::cout << "  value " << it.number << ' ' << it.value << ' ' << sum / ++n << '\n';
+        }
+    }
+}
+
+void usage()
+{
+    std::cerr << "Usage: replay FILE [options]\n"
+              << "  --paths N    Selection paths printed per search (default 0)\n"
+              << "  --values     Rollout values and their running mean, per iteration\n"
+              << "  --search K   Only the K-th search of the trace\n"
+              << "  --dump       Every event, one per line" << std::endl;
+}
+
+// Rebuilds the searches from a trace flushed by Trace::Ring::flush() (see trace.h),
+// and reports the latencies of their phases, how their descents went, and
+// optionally their paths and values.
+int main(int argc, char* argv[])
+{
+    std::string path;
+    int n_paths = 0;
+    int only = -1;
+    bool values = false, dump = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "--paths")         n_paths = std::atoi(next().c_str());
+        else if (arg == "--values")   values = true;
+        else if (arg == "--search")   only = std::atoi(next().c_str());
+        else if (arg == "--dump")     dump = true;
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (path.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<Event> events;
+    Trace::Header header;
+    if (!Trace::load(path, events, &header))
+    {
+        std::cerr << "Could not read trace " << path << std::endl;
+        return 1;
+    }
+
+    std::cout << events.size() << " events, " << header.n_dropped << " overwritten\n";
+
+    if (dump)
+    {
+        uint64_t t0 = events.empty() ? 0 : events[0].time_ns;
+        for (const auto& e : events)
+            std::cout << (e.time_ns ? e.time_ns - t0 : 0) << ' ' << Trace::type_name(Trace::EventType(e.type))
+                      << " it=" << e.iteration << " depth=" << int(e.depth) << " move=" << e.move
+                      << " edge=" << int(e.edge) << " value=" << e.value << '\n';
+    }
+
+    auto searches = rebuild(events);
+
+    std::vector<uint64_t> selection, simulation, backpropagation, total;
+    for (int k = 0; k < (int)searches.size(); ++k)
+    {
+        if (only >= 0 && k != only)
+            continue;
+
+        for (const auto& it : searches[k].iterations)
+        {
+            if (!it.complete())
+                continue;
+            selection.push_back(it.leaf - it.start);
+            simulation.push_back(it.rollout - it.leaf);
+            backpropagation.push_back(it.backup - it.rollout);
+            total.push_back(it.backup - it.start);
+        }
+    }
+
+    std::cout << "\nLatencies (ns)     mean       p50       p99       max\n";
+    print_latencies("selection", selection);
+    print_latencies("simulation", simulation);
+    print_latencies("backpropagation", backpropagation);
+    print_latencies("iteration", total);
+
+    for (int k = 0; k < (int)searches.size(); ++k)
+    {
+        if (only < 0 || k == only)
+            print_search(searches[k], k, n_paths, values);
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mcts.h"
+#include "solver.h"
+
+using namespace mcts;
+
+// Proportion of the agent's moves that keep the game theoretic value, over
+// games against a random opponent (the agent alternates sides).
+double perfect_rate(const Solver::Table& table, int n_games, std::mt19937& rng)
+{
+    int perfect = 0, total = 0;
+
+    for (int g = 0; g < n_games; ++g)
+    {
+        MCTS.clear();
+
+        State state;
+        std::array<StateData, 10> sd;
+        Agent agent(state);
+        Token side = g & 1 ? O : X;
+
+        for (int i = 0; !state.is_terminal(); ++i)
+        {
+            Move move;
+            if (state.next_player() == side)
+            {
+                move = agent.MCTSBestMove();
+                perfect += table.is_perfect(state, move);
+                ++total;
+            }
+            else
+            {
+                auto& moves = state.valid_actions();
+                move = moves[rng() % moves.size()];
+            }
+            state.apply_move(move, sd[i]);
+        }
+    }
+
+    return total ? double(perfect) / total : 1.0;
+}
+
+int main(int argc, char* argv[])
+{
+    int n_threads = 0;
+    int n_games = 50;
+    std::string output = "tictactoe.table";
+    std::vector<int> budgets;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "-t")             n_threads = std::atoi(next().c_str());
+        else if (arg == "-o")        output = next();
+        else if (arg == "--games")   n_games = std::atoi(next().c_str());
+        else if (arg == "--measure")
+        {
+            std::istringstream ss(next());
+            for (std::string b; std::getline(ss, b, ',');)
+                budgets.push_back(std::atoi(b.c_str()));
+        }
+        else
+        {
+            std::cerr << "Usage: retrograde [-t threads] [-o FILE] [--measure budgets] [--games N]" << std::endl;
+            return 1;
+        }
+    }
+
+    Solver::Table table;
+
+    auto start = std::chrono::steady_clock::now();
+    table.solve(n_threads);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::array<int, 4> counts {};
+    for (int i = 0; i < Solver::N_POSITIONS; ++i)
+        ++counts[table.value(i)];
+
+    std::cerr << "Solved in " << elapsed << "us: "
+              << counts[Solver::VALUE_WIN] << " wins, "
+              << counts[Solver::VALUE_DRAW] << " draws, "
+              << counts[Solver::VALUE_LOSS] << " losses, "
+              << counts[Solver::VALUE_NONE] << " unreachable encodings" << std::endl;
+
+    if (!table.save(output))
+    {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    if (budgets.empty())
+        return 0;
+
+    Agent::debug_counters = false;
+    std::mt19937 rng(std::random_device{}());
+
+    std::cout << "budget perfect_rate" << std::endl;
+    for (int budget : budgets)
+    {
+        Agent::set_max_iter(budget);
+        std::cout << budget << ' ' << perfect_rate(table, n_games, rng) << std::endl;
+    }
+
+    return 0;
+}
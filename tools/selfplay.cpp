@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include "mcts.h"
+#include "records.h"
+
+using namespace mcts;
+
+// One game of the agent against itself, the first plies at random so that the
+// games differ. Those are recorded with no visits.
+GameRecord play_game(int n_random, std::mt19937& rng)
+{
+    Agent::clear_table();
+
+    GameRecord record;
+    State state;
+    std::array<StateData, 10> sd;
+    Agent agent(state);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; !state.is_terminal(); ++i)
+    {
+        if (i < n_random)
+        {
+            auto& moves = state.valid_actions();
+            Move move = moves[rng() % moves.size()];
+            record.add(move, SearchInfo());
+            state.apply_move(move, sd[i]);
+            continue;
+        }
+
+        if (Agent::compact_tree)
+            agent.compact();
+
+        Move move = agent.MCTSBestMove();
+        record.add(move, agent.info());
+        state.apply_move(move, sd[i]);
+    }
+
+    record.winner = state.winner();
+    record.elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    return record;
+}
+
+// Summary of a file of records: the results, and the visits given to the moves played.
+int summarize(const std::string& path)
+{
+    RecordReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Cannot read the records in " << path << std::endl;
+        return 1;
+    }
+
+    std::array<uint64_t, 3> results {};    // Draws, X, O.
+    uint64_t n_games = 0, n_plies = 0, iterations = 0, elapsed_us = 0;
+    uint64_t chosen = 0, searched = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (const GameRecord* r = reader.next())
+    {
+        ++n_games;
+        n_plies += r->n_plies;
+        iterations += r->iterations;
+        elapsed_us += r->elapsed_us;
+        ++results[r->winner == X ? 1 : r->winner == O ? 2 : 0];
+
+        for (int p = 0; p < r->n_plies; ++p)
+        {
+            const auto& ply = r->plies[p];
+            for (int v : ply.visits)
+                searched += v;
+            chosen += ply.visits[ply.cell];
+        }
+    }
+
+    double read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Records:        " << n_games << (reader.compressed() ? " (compressed)" : "") << '\n'
+              << "X / O / draws:  " << results[1] << " / " << results[2] << " / " << results[0] << '\n'
+              << "Plies per game: " << (n_games ? double(n_plies) / n_games : 0.0) << '\n'
+              << "Iterations:     " << iterations << '\n'
+              << "Search time:    " << elapsed_us / 1000 << " ms\n"
+              << "Chosen visits:  " << (searched ? 100.0 * chosen / searched : 0.0) << " %\n"
+              << "Read in:        " << read_ms << " ms" << std::endl;
+
+    return 0;
+}
+
+void usage()
+{
+    std::cerr << "Usage: selfplay [options]\n"
+              << "  -o FILE       Write the records of the games to FILE\n"
+              << "  --compress    Compress the blocks of records\n"
+              << "  --games N     Games to play (default 1000)\n"
+              << "  --iter N      Iterations per move (default 1000)\n"
+              << "  --random N    Plies played at random at the start of the games (default 1)\n"
+              << "  --seed N      Seed of the random plies\n"
+              << "  --read FILE   Summarize the records of FILE and exit" << std::endl;
+}
+
+// The games are played on one thread: the agents share the table of nodes. The
+// writer compresses and writes the records on its own thread meanwhile.
+int main(int argc, char* argv[])
+{
+    std::string output;
+    bool compress = false;
+    int n_games = 1000, n_random = 1;
+    unsigned seed = std::random_device{}();
+
+    Agent::set_max_iter(1000);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "-o")               output = next();
+        else if (arg == "--compress")  compress = true;
+        else if (arg == "--games")     n_games = std::atoi(next().c_str());
+        else if (arg == "--iter")      Agent::set_max_iter(std::atoi(next().c_str()));
+        else if (arg == "--random")    n_random = std::atoi(next().c_str());
+        else if (arg == "--seed")      seed = std::atoi(next().c_str());
+        else if (arg == "--read")      return summarize(next());
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (output.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    RecordWriter writer;
+    if (!writer.open(output, compress))
+    {
+        std::cerr << "Cannot create " << output << std::endl;
+        return 1;
+    }
+
+    Agent::debug_counters = false;
+    Agent::use_time = false;
+
+    std::mt19937 rng(seed);
+    auto start = std::chrono::steady_clock::now();
+    {
+        RecordWriter::Buffer buffer(writer);
+        for (int g = 0; g < n_games; ++g)
+            buffer.add(play_game(n_random, rng));
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!writer.close())
+    {
+        std::cerr << "Failed writing " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << n_games << " games in " << ms << " ms, " << writer.n_records() << " records, "
+              << writer.bytes_written() << " bytes ("
+              << double(writer.bytes_written()) / std::max<uint64_t>(1, writer.n_records()) << " per game)" << std::endl;
+
+    return 0;
+}
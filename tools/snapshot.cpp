@@ -0,0 +1,80 @@
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include "mcts.h"
+#include "snapshot.h"
+
+using namespace mcts;
+
+// Builds the opening statistics by self-play and saves them in a snapshot
+// that later processes can map at startup (see Agent::warm_start).
+int main(int argc, char* argv[])
+{
+    int n_games = 20;
+    std::string output = "mcts.snapshot";
+    std::string input;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "--iter")           Agent::set_max_iter(std::atoi(next().c_str()));
+        else if (arg == "--games")     n_games = std::atoi(next().c_str());
+        else if (arg == "--profile")   Agent::load_profile(next());
+        else if (arg == "--from")      input = next();
+        else if (arg == "-o")          output = next();
+        else
+        {
+            std::cerr << "Usage: snapshot [--iter N] [--games N] [--profile FILE] [--from FILE] [-o FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Extend an existing snapshot rather than starting over.
+    if (!input.empty())
+    {
+        Snapshot base;
+        if (!base.open(input))
+        {
+            std::cerr << "Could not map snapshot " << input << std::endl;
+            return 1;
+        }
+        for (const auto& rec : base)
+            Snapshot::to_node(rec, MCTS[rec.key]);
+    }
+
+    Agent::debug_counters = false;
+    std::mt19937 rng(std::random_device{}());
+
+    for (int g = 0; g < n_games; ++g)
+    {
+        State state;
+        std::array<StateData, 10> sd;
+        Agent agent(state);
+
+        for (int i = 0; !state.is_terminal(); ++i)
+        {
+            Move move = agent.MCTSBestMove();
+
+            // Diversify the openings a bit.
+            auto& moves = state.valid_actions();
+            if (rng() % 4 == 0)
+                move = moves[rng() % moves.size()];
+
+            state.apply_move(move, sd[i]);
+        }
+    }
+
+    if (!Snapshot::save(output))
+    {
+        std::cerr << "Could not write snapshot " << output << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Saved " << MCTS.size() << " nodes to " << output << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tuner.h"
+
+using namespace mcts;
+
+void usage()
+{
+    std::cerr << "Usage: tune [options]\n"
+              << "  --iter N          Iteration budget per move (default 1000, or the profile's)\n"
+              << "  --time MS         Time budget per move, instead of iterations (default the profile's)\n"
+              << "  --budgets a,b,..  Find the cheapest of these budgets reaching perfect play\n"
+              << "  --steps N         Number of SPSA steps (default 50)\n"
+              << "  --games N         Games per evaluation (default 12)\n"
+              << "  --seed N          Seed of the optimizer\n"
+              << "  --from FILE       Start from a saved profile\n"
+              << "  -o FILE           Where to save the tuned profile (default mcts.profile)\n"
+              << "  -v                Report every step" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    Tuner::Config config;
+    std::vector<int> budgets;
+    std::string output = "mcts.profile";
+    std::string from;
+    int max_iter = 0;
+    int max_time = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+
+        if (arg == "--iter")         max_iter = std::atoi(next().c_str());
+        else if (arg == "--time")    max_time = std::atoi(next().c_str());
+        else if (arg == "--steps")   config.n_steps = std::atoi(next().c_str());
+        else if (arg == "--games")   config.games_per_eval = std::atoi(next().c_str());
+        else if (arg == "--seed")    config.seed = std::atoi(next().c_str());
+        else if (arg == "-o")        output = next();
+        else if (arg == "-v")        config.verbose = true;
+        else if (arg == "--from")    from = next();
+        else if (arg == "--budgets")
+        {
+            std::istringstream ss(next());
+            for (std::string b; std::getline(ss, b, ',');)
+                budgets.push_back(std::atoi(b.c_str()));
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // The profile's budget is the default, the command line has the last word whatever the order.
+    if (!from.empty())
+    {
+        if (!Agent::load_profile(from))
+        {
+            std::cerr << "Could not read profile " << from << std::endl;
+            return 1;
+        }
+        // A time budget stays one, MAX_TIME having the search's margin on top.
+        if (Agent::use_time)
+            config.max_time = std::max(1, Agent::MAX_TIME - Agent::TIME_MARGIN);
+        else
+            config.max_iter = Agent::MAX_ITER;
+    }
+    if (max_iter > 0)
+    {
+        config.max_iter = max_iter;
+        config.max_time = 0;
+    }
+    if (max_time > 0)
+        config.max_time = max_time;
+
+    Tuner::Params params = Tuner::current();
+
+    if (budgets.empty())
+        params = Tuner::spsa(params, config);
+    else
+    {
+        int budget = Tuner::cheapest_budget(budgets, params, params, config);
+        if (budget < 0)
+            std::cerr << "No budget reached perfect play, saving the last tuned parameters." << std::endl;
+        else
+            std::cerr << "Cheapest budget reaching perfect play: " << budget << std::endl;
+    }
+
+    Tuner::apply(params);
+    if (!Agent::save_profile(output))
+    {
+        std::cerr << "Could not write profile " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << "exploration_cst " << params.exploration_cst
+              << "\npropagate_minimax " << params.propagate_minimax
+              << "\nn_rollouts " << params.n_rollouts << std::endl;
+
+    return 0;
+}